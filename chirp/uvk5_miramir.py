@@ -70,6 +70,7 @@ import os
 
 import struct
 import logging
+import time
 import wx
 
 from chirp import chirp_common, directory, bitwise, memmap, errors, util
@@ -622,6 +623,21 @@ PROG_SIZE = 0x1d00  # size of the memory that we will write
 MEM_BLOCK = 0x80  # largest block of memory that we can reliably write
 CAL_START = 0x1E00  # calibration memory start address
 F4HWN_START =0x1FF2 # calibration F4HWN memory start address
+BULK_READ_BLOCK = 0x80  # largest block of a bulk read
+BULK_WRITE_BLOCK = 0xE0  # largest block of a bulk write (7 pages)
+CRC_BLOCK = 0x100  # memory covered by each block CRC
+CRC_BLOCKS_MAX = 4  # most block CRCs the radio computes per request
+FAST_BAUD_RATE = 115200  # rate asked for when the radio can change it
+BAUD_FALLBACK_WAIT = 2.5  # radio drops an unconfirmed rate after 2 s
+READ_FRAME = 20  # bytes a read request takes in the radio's receive ring
+READ_RETRIES = 3  # times lost read replies are asked for again
+
+# capabilities advertised in the hello reply
+CAPS_MAGIC = 0xC5
+CAP_BULK = 0x01
+CAP_BLOCK_CRC = 0x02
+CAP_BAUD_RATE = 0x04
+CAP_FLOW = 0x08
 
 # fm radio supported frequencies
 FMMIN = 76.0
@@ -718,7 +734,7 @@ def _send_command(serport, data: bytes):
     crc = calculate_crc16_xmodem(data)
     data2 = data + struct.pack("<H", crc)
 
-    command = struct.pack(">HBB", 0xabcd, len(data), 0) + \
+    command = struct.pack(">H", 0xabcd) + struct.pack("<H", len(data)) + \
         xorarr(data2) + \
         struct.pack(">H", 0xdcba)
     if DEBUG_SHOW_OBFUSCATED_COMMANDS:
@@ -736,13 +752,14 @@ def _receive_reply(serport):
         LOG.warning("Header short read: [%s] len=%i",
                     util.hexprint(header), len(header))
         raise errors.RadioError("Header short read")
-    if header[0] != 0xAB or header[1] != 0xCD or header[3] != 0x00:
+    if header[0] != 0xAB or header[1] != 0xCD:
         LOG.warning("Bad response header: %s len=%i",
                     util.hexprint(header), len(header))
         raise errors.RadioError("Bad response header")
 
-    cmd = serport.read(int(header[2]))
-    if len(cmd) != int(header[2]):
+    length = struct.unpack("<H", header[2:4])[0]
+    cmd = serport.read(length)
+    if len(cmd) != length:
         LOG.warning("Body short read: [%s] len=%i",
                     util.hexprint(cmd), len(cmd))
         raise errors.RadioError("Command body short read")
@@ -791,6 +808,10 @@ def _sayhello(serport):
         LOG.debug("Sending hello packet")
         _send_command(serport, hellopacket)
         rep = _receive_reply(serport)
+        # a radio streaming telemetry or trace records may have one on
+        # the wire ahead of the reply, the hello stops them
+        while rep and rep[:2] in (b"\x42\x05", b"\x48\x05"):
+            rep = _receive_reply(serport)
         if rep:
             break
         tries -= 1
@@ -802,17 +823,45 @@ def _sayhello(serport):
                                 "restart radio into normal mode")
     firmware = _getstring(rep, 4, 24)
 
-    LOG.info("Found firmware: %s", firmware)
-    return firmware
+    # stock firmware leaves these bytes as padding
+    caps = 0
+    if len(rep) > 23 and rep[22] == CAPS_MAGIC:
+        caps = rep[23]
 
+    LOG.info("Found firmware: %s capabilities: 0x%2.2x", firmware, caps)
+    return firmware, caps
 
-def _readmem(serport, offset, length):
-    LOG.debug("Sending readmem offset=0x%4.4x len=0x%4.4x", offset, length)
 
-    readmem = b"\x1b\x05\x08\x00" + \
-        struct.pack("<HBB", offset, length, 0) + \
-        b"\x6a\x39\x57\x64"
+def _sendreadmem(serport, offset, length, bulk):
+    """ask for a block, without waiting for the reply"""
+    if bulk:
+        LOG.debug("Sending bulk readmem offset=0x%4.4x len=0x%4.4x",
+                  offset, length)
+        readmem = b"\x35\x05\x08\x00" + \
+            struct.pack("<HH", offset, length) + \
+            b"\x6a\x39\x57\x64"
+    else:
+        LOG.debug("Sending readmem offset=0x%4.4x len=0x%4.4x",
+                  offset, length)
+        readmem = b"\x1b\x05\x08\x00" + \
+            struct.pack("<HBB", offset, length, 0) + \
+            b"\x6a\x39\x57\x64"
     _send_command(serport, readmem)
+
+
+def _parsereadmem(rep):
+    """offset and data of a readmem or bulk readmem reply"""
+    if rep[0] == 0x1c and len(rep) >= 8:
+        offset, length = struct.unpack("<HB", rep[4:7])
+    elif rep[0] == 0x36 and len(rep) >= 8:
+        offset, length = struct.unpack("<HH", rep[4:8])
+    else:
+        return None, b""
+    return offset, rep[8:8+length]
+
+
+def _readmem(serport, offset, length):
+    _sendreadmem(serport, offset, length, False)
     rep = _receive_reply(serport)
     if DEBUG_SHOW_MEMORY_ACTIONS:
         LOG.debug("readmem Received data len=0x%4.4x:\n%s",
@@ -848,6 +897,164 @@ def _writemem(serport, data, offset):
     raise errors.RadioError("Bad response to writemem")
 
 
+def _writemem_bulk(serport, data, offset):
+    LOG.debug("Sending bulk writemem offset=0x%4.4x len=0x%4.4x",
+              offset, len(data))
+
+    if DEBUG_SHOW_MEMORY_ACTIONS:
+        LOG.debug("bulk writemem sent data offset=0x%4.4x len=0x%4.4x:\n%s",
+                  offset, len(data), util.hexprint(data))
+
+    dlen = len(data)
+    writemem = b"\x37\x05" + \
+        struct.pack("<HHHB3x", dlen+12, offset, dlen, 1) + \
+        b"\x6a\x39\x57\x64"+data
+
+    _send_command(serport, writemem)
+    rep = _receive_reply(serport)
+
+    LOG.debug("bulk writemem Received data: %s len=%i",
+              util.hexprint(rep), len(rep))
+
+    # the radio writes whole 8 byte blocks only, like with writemem
+    if (rep[0] == 0x38 and
+       struct.unpack("<HH", rep[4:8]) == (offset, dlen & ~7)):
+        return True
+
+    LOG.warning("Bad data from bulk writemem")
+    raise errors.RadioError("Bad response to bulk writemem")
+
+
+def _readcrcs(serport, offset, count):
+    LOG.debug("Sending block crc offset=0x%4.4x count=%i", offset, count)
+
+    readcrc = b"\x39\x05\x08\x00" + \
+        struct.pack("<HH", offset, count) + \
+        b"\x6a\x39\x57\x64"
+    _send_command(serport, readcrc)
+    rep = _receive_reply(serport)
+
+    if (rep[0] != 0x3a or
+       struct.unpack("<HH", rep[4:8]) != (offset, count)):
+        LOG.warning("Bad data from block crc")
+        raise errors.RadioError("Bad response to block crc")
+    return struct.unpack("<%iH" % count, rep[8:8+count*2])
+
+
+def _readmem_window(serport, start, stop, block, window, bulk, progress):
+    """read start..stop in blocks, keeping up to window requests in
+    flight so the link is busy both ways; replies are matched to the
+    requests by their offset, lost ones are asked for again"""
+    pending = list(range(start, stop, block))
+    inflight = []
+    blocks = {}
+    retries = READ_RETRIES
+
+    while pending or inflight:
+        while pending and len(inflight) < window:
+            offset = pending.pop(0)
+            _sendreadmem(serport, offset, min(block, stop-offset), bulk)
+            inflight.append(offset)
+
+        try:
+            offset, data = _parsereadmem(_receive_reply(serport))
+        except errors.RadioError:
+            if retries == 0:
+                raise
+            retries -= 1
+            LOG.warning("Lost %i read replies, asking again", len(inflight))
+            # let whatever is still on its way arrive, then drop it
+            while serport.read(256):
+                pass
+            serport.reset_input_buffer()
+            pending = inflight + pending
+            inflight = []
+            continue
+
+        if offset not in inflight or len(data) != min(block, stop-offset):
+            LOG.debug("Ignoring unexpected read reply offset=%s", offset)
+            continue
+
+        if DEBUG_SHOW_MEMORY_ACTIONS:
+            LOG.debug("readmem Received data offset=0x%4.4x len=0x%4.4x:\n%s",
+                      offset, len(data), util.hexprint(data))
+        inflight.remove(offset)
+        blocks[offset] = data
+        progress(len(blocks) * block)
+
+    return b"".join(blocks[offset] for offset in sorted(blocks))
+
+
+def _readwindow(serport):
+    """receive ring size, bytes free in it, largest command and largest
+    bulk write the radio takes"""
+    LOG.debug("Sending window query")
+
+    window = b"\x3d\x05\x04\x00" + \
+        b"\x6a\x39\x57\x64"
+    _send_command(serport, window)
+    rep = _receive_reply(serport)
+
+    if rep[0] != 0x3e or len(rep) < 12:
+        LOG.warning("Bad data from window query")
+        raise errors.RadioError("Bad response to window query")
+    ring, free, cmdmax, writemax = struct.unpack("<HHHH", rep[4:12])
+    LOG.info("Radio receive ring %i bytes, largest bulk write %i",
+             ring, writemax)
+    return ring, free, cmdmax, writemax
+
+
+def _changed_ranges(serport, mmap, start_addr, stop_addr):
+    """memory ranges whose block crc differs from the radio's"""
+    crcs = []
+    for offset in range(start_addr, stop_addr, CRC_BLOCKS_MAX*CRC_BLOCK):
+        count = min(CRC_BLOCKS_MAX, (stop_addr-offset)//CRC_BLOCK)
+        crcs += _readcrcs(serport, offset, count)
+    ranges = []
+    for i, crc in enumerate(crcs):
+        addr = start_addr + i*CRC_BLOCK
+        if calculate_crc16_xmodem(mmap[addr:addr+CRC_BLOCK]) == crc:
+            continue
+        if ranges and ranges[-1][1] == addr:
+            ranges[-1][1] = addr+CRC_BLOCK
+        else:
+            ranges.append([addr, addr+CRC_BLOCK])
+    LOG.info("Uploading %i of %i blocks", sum(e-s for s, e in ranges)
+             // CRC_BLOCK, len(crcs))
+    return ranges
+
+
+def _setbaud(serport, baud):
+    """switch both ends to baud, the radio falls back on its own when
+    the first command at the new rate does not make it through"""
+    LOG.debug("Sending setbaud %i", baud)
+
+    oldbaud = serport.baudrate
+    setbaud = b"\x3b\x05\x08\x00" + \
+        struct.pack("<I", baud) + \
+        b"\x6a\x39\x57\x64"
+    _send_command(serport, setbaud)
+    rep = _receive_reply(serport)
+
+    if rep[0] != 0x3c or not rep[8]:
+        LOG.info("Radio refused %i baud", baud)
+        return False
+
+    serport.baudrate = baud
+    try:
+        _sayhello(serport)
+        LOG.info("Switched to %i baud", baud)
+        return True
+    except errors.RadioError:
+        LOG.warning("No answer at %i baud, back to %i", baud, oldbaud)
+
+    serport.baudrate = oldbaud
+    time.sleep(BAUD_FALLBACK_WAIT)
+    serport.reset_input_buffer()
+    _sayhello(serport)
+    return False
+
+
 def _resetradio(serport):
     resetpacket = b"\xdd\x05\x00\x00"
     _send_command(serport, resetpacket)
@@ -863,24 +1070,35 @@ def do_download(radio):
     status.msg = "Downloading from radio"
     radio.status_fn(status)
 
-    eeprom = b""
-    f = _sayhello(serport)
+    f, caps = _sayhello(serport)
     if f:
         radio.FIRMWARE_VERSION = f
     else:
         raise errors.RadioError("Failed to initialize radio")
 
-    addr = 0
-    while addr < MEM_SIZE:
-        data = _readmem(serport, addr, MEM_BLOCK)
-        status.cur = addr
+    if caps & CAP_BAUD_RATE:
+        _setbaud(serport, FAST_BAUD_RATE)
+
+    # a radio telling how much it can take gets several requests at once,
+    # any other one a request at a time
+    window = 1
+    if caps & CAP_FLOW:
+        window = max(1, _readwindow(serport)[1] // READ_FRAME)
+
+    def progress(done):
+        status.cur = min(done, MEM_SIZE)
         radio.status_fn(status)
 
-        if data and len(data) == MEM_BLOCK:
-            eeprom += data
-            addr += MEM_BLOCK
-        else:
-            raise errors.RadioError("Memory download incomplete")
+    bulk = bool(caps & CAP_BULK)
+    block = BULK_READ_BLOCK if bulk else MEM_BLOCK
+    eeprom = _readmem_window(serport, 0, MEM_SIZE, block, window, bulk,
+                             progress)
+    if len(eeprom) != MEM_SIZE:
+        raise errors.RadioError("Memory download incomplete")
+
+    # leave the radio ready for the next session at the usual rate
+    if serport.baudrate != radio.BAUD_RATE:
+        _setbaud(serport, radio.BAUD_RATE)
 
     return memmap.MemoryMapBytes(eeprom)
 
@@ -911,25 +1129,53 @@ def do_upload(radio):
 
     radio.status_fn(status)
 
-    f = _sayhello(serport)
+    f, caps = _sayhello(serport)
     if f:
         radio.FIRMWARE_VERSION = f
     else:
         return False
 
-    addr = start_addr
-    while addr < stop_addr:
-        dat = radio.get_mmap()[addr:addr+MEM_BLOCK]
-        _writemem(serport, dat, addr)
-        status.cur = addr - start_addr
-        radio.status_fn(status)
-        if dat:
-            addr += MEM_BLOCK
-        else:
-            raise errors.RadioError("Memory upload incomplete")
+    if caps & CAP_BAUD_RATE:
+        _setbaud(serport, FAST_BAUD_RATE)
+
+    # only write the blocks that differ from what the radio holds
+    ranges = [[start_addr, stop_addr]]
+    if (caps & CAP_BLOCK_CRC and start_addr % CRC_BLOCK == 0 and
+       stop_addr % CRC_BLOCK == 0):
+        ranges = _changed_ranges(serport, radio.get_mmap(),
+                                 start_addr, stop_addr)
+        status.max = max(1, sum(e-s for s, e in ranges))
+
+    # a radio built with a larger receive ring takes larger writes
+    writeblock = BULK_WRITE_BLOCK
+    if caps & CAP_FLOW:
+        writeblock = _readwindow(serport)[3] or BULK_WRITE_BLOCK
+
+    done = 0
+    for range_start, range_stop in ranges:
+        addr = range_start
+        while addr < range_stop:
+            if caps & CAP_BULK:
+                block = min(writeblock, range_stop - addr)
+                dat = radio.get_mmap()[addr:addr+block]
+                _writemem_bulk(serport, dat, addr)
+            else:
+                block = MEM_BLOCK
+                dat = radio.get_mmap()[addr:addr+block]
+                _writemem(serport, dat, addr)
+            status.cur = done + addr - range_start
+            radio.status_fn(status)
+            if dat:
+                addr += block
+            else:
+                raise errors.RadioError("Memory upload incomplete")
+        done += range_stop - range_start
     status.msg = "Uploaded OK"
 
     _resetradio(serport)
+    # the radio restarts at the usual rate
+    serport.flush()
+    serport.baudrate = radio.BAUD_RATE
 
     return True
 
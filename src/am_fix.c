@@ -388,6 +388,11 @@ int8_t AM_fix_get_gain_diff()
     return currentGainDiff;
 }
 
+uint8_t AM_fix_get_gain_index(const unsigned vfo)
+{
+    return (vfo < ARRAY_SIZE(gain_table_index)) ? gain_table_index[vfo] : 0;
+}
+
 void AM_fix_enable(bool on)
 {
     enabled = on;
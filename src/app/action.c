@@ -20,6 +20,9 @@
 #include "app/action.h"
 #include "app/app.h"
 #include "app/chFrScanner.h"
+#ifdef ENABLE_CHAN_SEARCH
+    #include "app/chsearch.h"
+#endif
 #include "app/common.h"
 #include "app/dtmf.h"
 #ifdef ENABLE_FLASHLIGHT
@@ -30,6 +33,7 @@
 #endif
 #include "app/scanner.h"
 #include "bsp/dp32g030/gpio.h"
+#include "chcache.h"
 #ifdef ENABLE_FMRADIO
     #include "driver/bk1080.h"
 #endif
@@ -38,6 +42,7 @@
 #include "driver/backlight.h"
 #include "functions.h"
 #include "misc.h"
+#include "radio.h"
 #include "settings.h"
 #include "ui/inputbox.h"
 #include "ui/ui.h"
@@ -94,6 +99,12 @@ void (*action_opt_table[])(void) = {
     [ACTION_OPT_PTT] = &ACTION_Ptt,
     [ACTION_OPT_WN] = &ACTION_Wn,
     [ACTION_OPT_BACKLIGHT] = &ACTION_BackLight,
+    [ACTION_OPT_SNAP_MEM] = &ACTION_SnapToMemory,
+#ifdef ENABLE_CHAN_SEARCH
+    [ACTION_OPT_CH_SEARCH] = &ACTION_ChannelSearch,
+#else
+    [ACTION_OPT_CH_SEARCH] = &FUNCTION_NOP,
+#endif
 };
 
 static_assert(ARRAY_SIZE(action_opt_table) == ACTION_OPT_LEN);
@@ -426,6 +437,39 @@ void ACTION_Wn(void)
     }
 }
 
+// tune the VFO to the frequency of the closest memory channel
+void ACTION_SnapToMemory(void)
+{
+    const uint8_t Vfo = gEeprom.TX_VFO;
+
+    if (!IS_FREQ_CHANNEL(gEeprom.ScreenChannel[Vfo]) || gScanStateDir != SCAN_OFF)
+        return;
+
+    const uint8_t channel = CHCACHE_FindNearestChannel(gTxVfo->freq_config_RX.Frequency);
+    if (channel == 0xFF)
+        return;
+
+    const uint32_t Frequency = CHCACHE_GetFrequency(channel);
+
+    RADIO_SelectBand(Vfo, Frequency);
+
+    gTxVfo->freq_config_RX.Frequency = Frequency;
+
+    gRequestSaveChannel   = 1;
+    gRequestDisplayScreen = DISPLAY_MAIN;
+}
+
+#ifdef ENABLE_CHAN_SEARCH
+void ACTION_ChannelSearch(void)
+{
+    if (gScanStateDir != SCAN_OFF)
+        return;
+
+    GUI_SelectNextDisplay(DISPLAY_CHSEARCH);
+    CHSEARCH_Start();
+}
+#endif
+
 void ACTION_BackLight(void)
 {
     if(gBackLight)
@@ -38,6 +38,10 @@ void ACTION_Ptt(void);
 void ACTION_Wn(void);
 void ACTION_BackLightOnDemand(void);
 void ACTION_BackLight(void);
+void ACTION_SnapToMemory(void);
+#ifdef ENABLE_CHAN_SEARCH
+    void ACTION_ChannelSearch(void);
+#endif
 
 void ACTION_Handle(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld);
 
@@ -22,6 +22,9 @@
 #include "app/action.h"
 #include "app/app.h"
 #include "app/chFrScanner.h"
+#ifdef ENABLE_CHAN_SEARCH
+    #include "app/chsearch.h"
+#endif
 #include "app/dtmf.h"
 #ifdef ENABLE_FLASHLIGHT
     #include "app/flashlight.h"
@@ -33,6 +36,9 @@
 #include "app/main.h"
 #include "app/menu.h"
 #include "app/scanner.h"
+#if defined(ENABLE_SPECTRUM) && defined(ENABLE_UART)
+    #include "app/spectrum.h"
+#endif
 #ifdef ENABLE_UART
     #include "app/uart.h"
 #endif
@@ -45,6 +51,7 @@
     #include "driver/bk1080.h"
 #endif
 #include "driver/bk4819.h"
+#include "driver/eeprom.h"
 #include "driver/gpio.h"
 #include "driver/keyboard.h"
 #include "driver/st7565.h"
@@ -56,6 +63,9 @@
 #include "helper/battery.h"
 #include "misc.h"
 #include "radio.h"
+#ifdef ENABLE_SCAN_LOG
+    #include "scanlog.h"
+#endif
 #include "settings.h"
 #include "ui/battery.h"
 #include "ui/inputbox.h"
@@ -68,6 +78,7 @@
 static bool flagSaveVfo;
 static bool flagSaveSettings;
 static bool flagSaveChannel;
+static bool flagFlushEeprom;
 
 static void ProcessKey(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld);
 
@@ -80,6 +91,9 @@ void (*ProcessKeysFunctions[])(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld)
 #ifdef ENABLE_FMRADIO
     [DISPLAY_FM] = &FM_ProcessKeys,
 #endif
+#ifdef ENABLE_CHAN_SEARCH
+    [DISPLAY_CHSEARCH] = &CHSEARCH_ProcessKeys,
+#endif
 };
 
 static_assert(ARRAY_SIZE(ProcessKeysFunctions) == DISPLAY_N_ELEM);
@@ -917,6 +931,12 @@ static void CheckKeys(void)
     // scan the hardware keys
     KEY_Code_t Key = KEYBOARD_Poll();
 
+#ifdef ENABLE_UART
+    // a key held down over the programming cable, the keypad comes first
+    if (Key == KEY_INVALID)
+        Key = UART_InjectedKey();
+#endif
+
     if (Key != KEY_INVALID) // any key pressed
         boot_counter_10ms = 0;   // cancel boot screen/beeps if any key pressed
 
@@ -995,6 +1015,20 @@ void APP_TimeSlice10ms(void)
         UART_HandleCommand();
         __enable_irq();
     }
+
+    UART_TimeSlice10ms();
+
+    #ifdef ENABLE_SPECTRUM
+        // asked for over the cable, runs until told to leave or EXIT
+        if (gRequestSpectrum) {
+            gRequestSpectrum = false;
+            if (gCurrentFunction != FUNCTION_TRANSMIT) {
+                APP_RunSpectrum();
+                gUpdateStatus  = true;
+                gUpdateDisplay = true;
+            }
+        }
+    #endif
 #endif
 
     if (gReducedService)
@@ -1049,6 +1083,18 @@ void APP_TimeSlice10ms(void)
 
     SCANNER_TimeSlice10ms();
 
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_TimeSlice10ms();
+#endif
+
+    // one page per slice, the burn itself runs while we carry on
+    if (flagFlushEeprom)
+        flagFlushEeprom = EEPROM_FlushStep();
+
+#ifdef ENABLE_CHAN_SEARCH
+    CHSEARCH_TimeSlice10ms();
+#endif
+
     CheckKeys();
 }
 
@@ -1079,6 +1125,16 @@ void APP_TimeSlice500ms(void)
 
     // Skipped authentic device check
 
+    SETTINGS_TimeSlice500ms();
+
+#ifdef ENABLE_UART
+    UART_TimeSlice500ms();
+#endif
+
+    // burn the pages buffered by EEPROM_WriteBuffer() while the radio is idle
+    if (EEPROM_IsDirty() && gCurrentFunction != FUNCTION_TRANSMIT)
+        flagFlushEeprom = true;
+
     if (gKeypadLocked > 0)
         if (--gKeypadLocked == 0)
             gUpdateDisplay = true;
@@ -1184,6 +1240,8 @@ void APP_TimeSlice500ms(void)
 
         if (gBatteryCurrent > 500 || gBatteryCalibration[3] < gBatteryCurrentVoltage)
         {
+            SETTINGS_CommitSettings();
+            EEPROM_Flush();
             NVIC_SystemReset();
         }
 
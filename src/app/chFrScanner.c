@@ -2,9 +2,11 @@
 #include "app/app.h"
 #include "app/chFrScanner.h"
 #include "functions.h"
+#include "helper/trace.h"
 #include "misc.h"
+#include "scanlist.h"
+#include "scanlog.h"
 #include "settings.h"
-//#include "debugging.h"
 
 int8_t            gScanStateDir;
 bool              gScanKeepResult;
@@ -154,6 +156,13 @@ void CHFRSCANNER_Found(void)
         lastFoundFrqOrChan = gRxVfo->freq_config_RX.Frequency;
     }
 
+    TRACE(TRACE_SCAN_FOUND, lastFoundFrqOrChan, 0);
+
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_Open(SCANLOG_SCANNER,
+                 IS_MR_CHANNEL(gRxVfo->CHANNEL_SAVE) ? gRxVfo->CHANNEL_SAVE : 0xFF,
+                 gRxVfo->freq_config_RX.Frequency, 0);
+#endif
 
     gScanKeepResult = true;
 }
@@ -167,6 +176,10 @@ void CHFRSCANNER_Stop(void)
     
     gScanStateDir = SCAN_OFF;
 
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_Close();
+#endif
+
     const uint32_t chFr = gScanKeepResult ? lastFoundFrqOrChan : initialFrqOrChan;
     const bool channelChanged = chFr != initialFrqOrChan;
     if (IS_MR_CHANNEL(gNextMrChannel)) {
@@ -184,7 +197,7 @@ void CHFRSCANNER_Stop(void)
         RADIO_ApplyOffset(gRxVfo);
         RADIO_ConfigureSquelchAndOutputPower(gRxVfo);
         if(channelChanged) {
-            SETTINGS_SaveChannel(gRxVfo->CHANNEL_SAVE, gEeprom.RX_VFO, gRxVfo, 1);
+            SETTINGS_SaveVfoFrequency(gEeprom.RX_VFO, gRxVfo);
         }
     }
 
@@ -194,6 +207,10 @@ void CHFRSCANNER_Stop(void)
 
 static void NextFreqChannel(void)
 {
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_Close();
+#endif
+
 #ifdef ENABLE_SCAN_RANGES
     if(gScanRangeStart) {
         gRxVfo->freq_config_RX.Frequency = APP_SetFreqByStepAndLimits(gRxVfo, gScanStateDir, gScanRangeStart, gScanRangeStop);
@@ -202,6 +219,8 @@ static void NextFreqChannel(void)
 #endif
         gRxVfo->freq_config_RX.Frequency = APP_SetFrequencyByStep(gRxVfo, gScanStateDir);
 
+    TRACE(TRACE_SCAN_FREQUENCY, gRxVfo->freq_config_RX.Frequency, 0);
+
     RADIO_ApplyOffset(gRxVfo);
     RADIO_ConfigureSquelchAndOutputPower(gRxVfo);
     RADIO_SetupRegisters(true);
@@ -224,7 +243,9 @@ static void NextMemChannel(void)
     const unsigned int  prev_chan    = gNextMrChannel;
     unsigned int        chan         = 0;
 
-    //char str[64] = "";
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_Close();
+#endif
 
     if (enabled)
     {
@@ -232,9 +253,8 @@ static void NextMemChannel(void)
         {
             case SCAN_NEXT_CHAN_SCANLIST1:
                 prev_mr_chan = gNextMrChannel;
-    
-                //sprintf(str, "-> Chan1 %d\n", chan1 + 1);
-                //LogUart(str);
+
+                TRACE(TRACE_SCAN_PRIORITY, 1, chan1 + 1);
 
                 if (chan1 >= 0)
                 {
@@ -249,8 +269,7 @@ static void NextMemChannel(void)
                 [[fallthrough]];
             case SCAN_NEXT_CHAN_SCANLIST2:
 
-                //sprintf(str, "-> Chan2 %d\n", chan2 + 1);
-                //LogUart(str);
+                TRACE(TRACE_SCAN_PRIORITY, 2, chan2 + 1);
 
                 if (chan2 >= 0)
                 {
@@ -302,7 +321,7 @@ static void NextMemChannel(void)
 
     if (!enabled || chan == 0xff)
     {       
-        chan = RADIO_FindNextChannel(gNextMrChannel + gScanStateDir, gScanStateDir, true, gEeprom.SCAN_LIST_DEFAULT);
+        chan = SCANLIST_NextChannel(gNextMrChannel, gScanStateDir);
         if (chan == 0xFF)
         {   // no valid channel found
             chan = MR_CHANNEL_FIRST;
@@ -310,8 +329,7 @@ static void NextMemChannel(void)
         
         gNextMrChannel = chan;
 
-        //sprintf(str, "----> Chan %d\n", chan + 1);
-        //LogUart(str);
+        TRACE(TRACE_SCAN_CHANNEL, chan + 1, 0);
     }
 
     if (gNextMrChannel != prev_chan)
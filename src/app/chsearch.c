@@ -0,0 +1,180 @@
+#ifdef ENABLE_CHAN_SEARCH
+
+#include <string.h>
+
+#include "app/chsearch.h"
+#include "app/generic.h"
+#include "chcache.h"
+#include "misc.h"
+#include "radio.h"
+#include "scanlist.h"
+#include "settings.h"
+#include "ui/ui.h"
+
+// a second press of the same key within this time cycles the letter
+#define MULTITAP_TIMEOUT_10ms 100
+
+char         gChSearchQuery[CHSEARCH_QUERY_LEN + 1];
+ChannelSet_t gChSearchMatches;
+uint8_t      gChSearchChannel;
+
+static const char * const gKeyLetters[10] = {
+    " 0", "1", "ABC2", "DEF3", "GHI4", "JKL5", "MNO6", "PQRS7", "TUV8", "WXYZ9"
+};
+
+static uint8_t gQueryLen;
+static uint8_t gLastKey;
+static uint8_t gTapIndex;
+static uint8_t gTapCountdown_10ms;
+
+static char ToUpper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+static bool NameContains(const char *pName, const char *pQuery)
+{
+    for (; *pName; pName++) {
+        unsigned int i = 0;
+        while (pQuery[i] && ToUpper(pName[i]) == pQuery[i])
+            i++;
+        if (!pQuery[i])
+            return true;
+    }
+    return !*pQuery;
+}
+
+static void UpdateMatches(void)
+{
+    char name[11];
+
+    CHANNELSET_Clear(&gChSearchMatches);
+
+    // the names of the selected bank are in RAM, see chcache.h
+    for (uint8_t ch = MR_CHANNEL_FIRST; IS_MR_CHANNEL(ch); ch++) {
+        if (!CHANNELSET_Contains(&gMR_ChannelValid, ch))
+            continue;
+        CHCACHE_FetchName(name, ch);
+        if (name[0] && NameContains(name, gChSearchQuery))
+            CHANNELSET_Assign(&gChSearchMatches, ch, true);
+    }
+
+    if (!CHANNELSET_Contains(&gChSearchMatches, gChSearchChannel))
+        gChSearchChannel = CHANNELSET_Next(&gChSearchMatches, MR_CHANNEL_LAST, 1);
+
+    gRequestDisplayScreen = DISPLAY_CHSEARCH;
+}
+
+void CHSEARCH_Start(void)
+{
+    gQueryLen          = 0;
+    gChSearchQuery[0]  = 0;
+    gLastKey           = KEY_INVALID;
+    gTapCountdown_10ms = 0;
+    gChSearchChannel   = 0xFF;
+
+    UpdateMatches();
+}
+
+void CHSEARCH_TimeSlice10ms(void)
+{
+    if (gTapCountdown_10ms > 0 && --gTapCountdown_10ms == 0)
+        gLastKey = KEY_INVALID;
+}
+
+static void CHSEARCH_Key_DIGITS(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld)
+{
+    if (bKeyHeld || !bKeyPressed)
+        return;
+
+    const char *letters = gKeyLetters[Key - KEY_0];
+
+    if (Key == gLastKey && gTapCountdown_10ms > 0 && gQueryLen > 0) {
+        // same key again, cycle the last letter
+        gTapIndex = (letters[gTapIndex + 1] != 0) ? gTapIndex + 1 : 0;
+        gChSearchQuery[gQueryLen - 1] = letters[gTapIndex];
+    }
+    else {
+        if (gQueryLen >= CHSEARCH_QUERY_LEN)
+            return;
+        gTapIndex = 0;
+        gChSearchQuery[gQueryLen++] = letters[0];
+        gChSearchQuery[gQueryLen]   = 0;
+    }
+
+    gLastKey           = Key;
+    gTapCountdown_10ms = MULTITAP_TIMEOUT_10ms;
+
+    UpdateMatches();
+}
+
+static void CHSEARCH_Key_EXIT(bool bKeyPressed, bool bKeyHeld)
+{
+    if (bKeyHeld || !bKeyPressed)
+        return;
+
+    if (gQueryLen == 0) {
+        gRequestDisplayScreen = DISPLAY_MAIN;
+        return;
+    }
+
+    gChSearchQuery[--gQueryLen] = 0;
+    gLastKey = KEY_INVALID;
+
+    UpdateMatches();
+}
+
+static void CHSEARCH_Key_MENU(bool bKeyPressed, bool bKeyHeld)
+{
+    if (bKeyHeld || !bKeyPressed)
+        return;
+
+    if (gChSearchChannel == 0xFF)
+        return;
+
+    // tune the current VFO to the selected memory channel
+    gEeprom.MrChannel[gEeprom.TX_VFO]     = gChSearchChannel;
+    gEeprom.ScreenChannel[gEeprom.TX_VFO] = gChSearchChannel;
+
+    gRequestSaveVFO       = true;
+    gVfoConfigureMode     = VFO_CONFIGURE_RELOAD;
+    gRequestDisplayScreen = DISPLAY_MAIN;
+}
+
+static void CHSEARCH_Key_UP_DOWN(bool bKeyPressed, int8_t Direction)
+{
+    if (!bKeyPressed || gChSearchChannel == 0xFF)
+        return;
+
+    gChSearchChannel      = CHANNELSET_Next(&gChSearchMatches, gChSearchChannel, Direction);
+    gLastKey              = KEY_INVALID;
+    gRequestDisplayScreen = DISPLAY_CHSEARCH;
+}
+
+void CHSEARCH_ProcessKeys(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld)
+{
+    switch (Key) {
+        case KEY_0...KEY_9:
+            CHSEARCH_Key_DIGITS(Key, bKeyPressed, bKeyHeld);
+            break;
+        case KEY_MENU:
+            CHSEARCH_Key_MENU(bKeyPressed, bKeyHeld);
+            break;
+        case KEY_UP:
+            CHSEARCH_Key_UP_DOWN(bKeyPressed, -1);
+            break;
+        case KEY_DOWN:
+            CHSEARCH_Key_UP_DOWN(bKeyPressed,  1);
+            break;
+        case KEY_EXIT:
+            CHSEARCH_Key_EXIT(bKeyPressed, bKeyHeld);
+            break;
+        case KEY_PTT:
+            GENERIC_Key_PTT(bKeyPressed);
+            break;
+        default:
+            break;
+    }
+}
+
+#endif
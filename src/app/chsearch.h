@@ -0,0 +1,27 @@
+#ifndef APP_CHSEARCH_H
+#define APP_CHSEARCH_H
+
+#ifdef ENABLE_CHAN_SEARCH
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "channelset.h"
+#include "driver/keyboard.h"
+
+#define CHSEARCH_QUERY_LEN 10
+
+// letters typed so far, upper case
+extern char         gChSearchQuery[CHSEARCH_QUERY_LEN + 1];
+// memory channels whose name contains the query
+extern ChannelSet_t gChSearchMatches;
+// highlighted match, 0xFF if there are none
+extern uint8_t      gChSearchChannel;
+
+void CHSEARCH_Start(void);
+void CHSEARCH_ProcessKeys(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld);
+void CHSEARCH_TimeSlice10ms(void);
+
+#endif
+
+#endif
@@ -37,6 +37,7 @@
 #include "frequencies.h"
 #include "misc.h"
 #include "radio.h"
+#include "scanlist.h"
 #include "settings.h"
 #include "ui/inputbox.h"
 #include "ui/ui.h"
@@ -59,9 +60,9 @@ static void toggle_chan_scanlist(void)
     }
     
     // Remove exclude
-    if(gMR_ChannelExclude[gTxVfo->CHANNEL_SAVE] == true)
+    if(CHANNELSET_Contains(&gMR_ChannelExclude, gTxVfo->CHANNEL_SAVE))
     {
-        gMR_ChannelExclude[gTxVfo->CHANNEL_SAVE] = false;
+        CHANNELSET_Assign(&gMR_ChannelExclude, gTxVfo->CHANNEL_SAVE, false);
         return;
     }
 
@@ -378,17 +379,7 @@ static void MAIN_Key_DIGITS(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld)
                 Frequency = frequencyBandTable[BAND_N_ELEM - 1].upper;
             }
 
-            const FREQUENCY_Band_t band = FREQUENCY_GetBand(Frequency);
-
-            if (gTxVfo->Band != band) {
-                gTxVfo->Band               = band;
-                gEeprom.ScreenChannel[Vfo] = band + FREQ_CHANNEL_FIRST;
-                gEeprom.FreqChannel[Vfo]   = band + FREQ_CHANNEL_FIRST;
-
-                SETTINGS_SaveVfoIndices();
-
-                RADIO_ConfigureChannel(Vfo, VFO_CONFIGURE_RELOAD);
-            }
+            RADIO_SelectBand(Vfo, Frequency);
 
             Frequency = FREQUENCY_RoundToStep(Frequency, gTxVfo->StepFrequency);
 
@@ -478,7 +469,7 @@ static void MAIN_Key_MENU(bool bKeyPressed, bool bKeyHeld)
             {
                 if(FUNCTION_IsRx())
                 {
-                    gMR_ChannelExclude[gTxVfo->CHANNEL_SAVE] = true;
+                    CHANNELSET_Assign(&gMR_ChannelExclude, gTxVfo->CHANNEL_SAVE, true);
 
                     gVfoConfigureMode = VFO_CONFIGURE;
                     gFlagResetVfos    = true;
@@ -161,6 +161,11 @@ int MENU_GetLimits(uint8_t menu_id, int32_t *pMin, int32_t *pMax)
             *pMax = 104;
             break;
 
+        case MENU_CH_BANK:
+            //*pMin = 0;
+            *pMax = SETTINGS_ChannelBankCount() - 1;
+            break;
+
         case MENU_ROGER:
             //*pMin = 0;
             *pMax = ARRAY_SIZE(gSubMenu_ROGER) - 1;
@@ -510,6 +515,12 @@ void MENU_AcceptSetting(void)
             gEeprom.SCAN_RESUME_MODE = gSubMenuSelection;
             break;
 
+        case MENU_CH_BANK:
+            SETTINGS_SelectChannelBank(gSubMenuSelection);
+            gVfoConfigureMode = VFO_CONFIGURE_RELOAD;
+            gFlagResetVfos    = true;
+            break;
+
         case MENU_MDF:
             gEeprom.CHANNEL_DISPLAY_MODE = gSubMenuSelection;
             break;
@@ -878,6 +889,10 @@ void MENU_ShowCurrentSetting(void)
             gSubMenuSelection = gEeprom.SCAN_RESUME_MODE;
             break;
 
+        case MENU_CH_BANK:
+            gSubMenuSelection = gEeprom.CHANNEL_BANK;
+            break;
+
         case MENU_MDF:
             gSubMenuSelection = gEeprom.CHANNEL_DISPLAY_MODE;
             break;
@@ -1344,6 +1359,8 @@ static void MENU_Key_MENU(const bool bKeyPressed, const bool bKeyHeld)
                     if (UI_MENU_GetCurrentMenuId() == MENU_RESET)
                     {
                         MENU_AcceptSetting();
+                        SETTINGS_CommitSettings();
+                        EEPROM_Flush();
                         NVIC_SystemReset();
                     }
 
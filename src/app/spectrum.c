@@ -18,18 +18,27 @@
 
 #include "app/spectrum.h"
 #include "am_fix.h"
+#include "chcache.h"
 #include "misc.h"
 
 #ifdef ENABLE_SCAN_RANGES
 #include "chFrScanner.h"
 #endif
 
+#ifdef ENABLE_UART
+#include "ARMCM0.h"
+#include "app/uart.h"
+#endif
+
 #include "driver/backlight.h"
 #include "frequencies.h"
 #include "ui/graphics.h"
 #include "ui/main.h"
 #include "audio.h"
 #include "driver/eeprom.h"
+#ifdef ENABLE_SCAN_LOG
+#include "scanlog.h"
+#endif
 
 struct FrequencyBandInfo
 {
@@ -55,6 +64,8 @@ bool newScanStart = true;
 bool preventKeypress = true;
 bool audioState = true;
 bool lockAGC = false;
+static bool triggerArmed = true;
+static uint16_t sweepCount;
 
 State currentState = SPECTRUM, previousState = SPECTRUM;
 
@@ -143,6 +154,7 @@ static void SaveSettings()
     Data[3] = (settings.scanStepIndex << 4) | (settings.stepsCount << 2) | settings.listenBw;
 
     EEPROM_WriteBuffer(0x1FF0, Data);
+    SETTINGS_SealSettings();
 }
 
 static uint8_t DBm2S(int dbm)
@@ -218,6 +230,12 @@ static void DrawVLine(int sy, int ey, int nx, bool fill)
 KEY_Code_t GetKey()
 {
     KEY_Code_t btn = KEYBOARD_Poll();
+#ifdef ENABLE_UART
+    if (btn == KEY_INVALID)
+    {
+        btn = UART_InjectedKey();
+    }
+#endif
     if (btn == KEY_INVALID && !GPIO_CheckBit(&GPIOC->DATA, GPIOC_PIN_PTT))
     {
         btn = KEY_PTT;
@@ -304,7 +322,7 @@ static void SetF(uint32_t f)
 
 // Spectrum related
 
-bool IsPeakOverLevel() { return peak.rssi >= settings.rssiTriggerLevel; }
+bool IsPeakOverLevel() { return triggerArmed && peak.rssi >= settings.rssiTriggerLevel; }
 
 static void ResetPeak()
 {
@@ -345,6 +363,9 @@ static void TuneToPeak()
 
 static void DeInitSpectrum()
 {
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_Close();
+#endif
     SetF(initialFreq);
     RestoreRegisters();
     isInitialized = false;
@@ -406,9 +427,22 @@ static void ToggleRX(bool on)
     else
     {
         BK4819_WriteRegister(0x43, GetBWRegValueForScan());
+#ifdef ENABLE_SCAN_LOG
+        SCANLOG_Close();
+#endif
     }
 }
 
+// the trigger fired: stop on the peak and listen
+static void ListenToPeak()
+{
+    ToggleRX(true);
+    TuneToPeak();
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_Open(SCANLOG_SPECTRUM, 0xFF, peak.f, peak.rssi);
+#endif
+}
+
 // Scan info
 
 static void ResetScanStats()
@@ -864,22 +898,15 @@ static void DrawStatus()
 
 static void ShowChannelName(uint32_t f)
 {
-    unsigned int i;
     memset(String, 0, sizeof(String));
 
     if (isListening)
     {
-        for (i = 0; IS_MR_CHANNEL(i); i++)
+        const uint8_t channel = CHCACHE_FindChannel(f);
+        if (channel != 0xFF)
         {
-            if (RADIO_CheckValidChannel(i, false, 0))
-            {
-                if (SETTINGS_FetchChannelFrequency(i) == f)
-                {
-                    SETTINGS_FetchChannelName(String, i);
-                    UI_PrintStringSmallBold(String[0] ? String : "--", 8, 127, 1);
-                    break;
-                }
-            }
+            SETTINGS_FetchChannelName(String, channel);
+            UI_PrintStringSmallBold(String[0] ? String : "--", 8, 127, 1);
         }
     }
 }
@@ -1377,12 +1404,12 @@ static void UpdateScan()
 
     redrawScreen = true;
     preventKeypress = false;
+    ++sweepCount;
 
     UpdatePeakInfo();
     if (IsPeakOverLevel())
     {
-        ToggleRX(true);
-        TuneToPeak();
+        ListenToPeak();
         return;
     }
 
@@ -1441,6 +1468,22 @@ static void UpdateListening()
 
 static void Tick()
 {
+#ifdef ENABLE_UART
+    // a command is handled between two steps, the sweep carries on
+    // where it was unless the command changed it
+    if (UART_IsCommandAvailable())
+    {
+        __disable_irq();
+        UART_HandleCommand();
+        __enable_irq();
+
+        if (!isInitialized)
+        {
+            return;
+        }
+    }
+#endif
+
     if (gNextTimeslice)
     {
         gNextTimeslice = false;
@@ -1448,13 +1491,23 @@ static void Tick()
         {
             AM_fix_10ms(vfo); // allow AM_Fix to apply its AGC action
         }
+#ifdef ENABLE_UART
+        UART_TimeSlice10ms();
+#endif
+#ifdef ENABLE_SCAN_LOG
+        SCANLOG_TimeSlice10ms();
+#endif
     }
 
-#ifdef ENABLE_SCAN_RANGES
     if (gNextTimeslice_500ms)
     {
         gNextTimeslice_500ms = false;
 
+#ifdef ENABLE_UART
+        UART_TimeSlice500ms();
+#endif
+
+#ifdef ENABLE_SCAN_RANGES
         // if a lot of steps then it takes long time
         // we don't want to wait for whole scan
         // listening has it's own timer
@@ -1463,15 +1516,14 @@ static void Tick()
             UpdatePeakInfo();
             if (IsPeakOverLevel())
             {
-                ToggleRX(true);
-                TuneToPeak();
+                ListenToPeak();
                 return;
             }
             redrawScreen = true;
             preventKeypress = false;
         }
-    }
 #endif
+    }
 
     if (!preventKeypress)
     {
@@ -1510,6 +1562,223 @@ static void Tick()
     }
 }
 
+#ifdef ENABLE_UART
+
+// Remote control. These run from UART_HandleCommand, between two steps
+// of Tick() or with the spectrum not running at all; starting it is left
+// to the main loop through gRequestSpectrum.
+
+bool gRequestSpectrum;
+
+static bool remoteStart;
+
+static struct
+{
+    uint32_t center;
+    ScanStep scanStepIndex;
+    StepsCount stepsCount;
+    BK4819_FilterBandwidth_t listenBw;
+    ModulationMode_t modulationType;
+} remote;
+
+static void ApplyRemoteSettings()
+{
+    settings.scanStepIndex = remote.scanStepIndex;
+    settings.stepsCount = remote.stepsCount;
+    settings.listenBw = remote.listenBw;
+    settings.modulationType = remote.modulationType;
+
+    const uint32_t half = GetBW() >> 1;
+    currentFreq = IsCenterMode() || remote.center < half ? remote.center : remote.center - half;
+    settings.frequencyChangeStep = half;
+
+    RADIO_SetModulation(settings.modulationType);
+    BK4819_SetFilterBandwidth(settings.listenBw, false);
+
+    if (currentState != SPECTRUM)
+    {
+        SetState(SPECTRUM);
+        lockAGC = false;
+        monitorMode = false;
+    }
+    RelaunchScan();
+    ResetBlacklist();
+    memset(rssiHistory, 0, sizeof(rssiHistory));
+    redrawScreen = true;
+    redrawStatus = true;
+}
+
+void SPECTRUM_GetStatus(SpectrumStatus *status)
+{
+    memset(status, 0, sizeof(*status));
+    status->fStart = GetFStart();
+    status->fEnd = status->fStart + GetBW();
+    status->f = fMeasure;
+    status->scanStep = GetScanStep();
+    status->stepsCount = GetStepsCount();
+    status->rssiTriggerLevel = settings.rssiTriggerLevel;
+    status->sweeps = sweepCount;
+    status->scanStepIndex = settings.scanStepIndex;
+    status->stepsCountIndex = settings.stepsCount;
+    status->listenBw = settings.listenBw;
+    status->modulationType = settings.modulationType;
+    status->state = currentState;
+    status->running = isInitialized;
+    status->triggerArmed = triggerArmed;
+    status->listening = isInitialized && isListening;
+    status->dBmCorrection = dBmCorrTable[gRxVfo->Band];
+}
+
+// sweep around center, starting the spectrum when it is not running
+bool SPECTRUM_Configure(uint32_t center, ScanStep scanStep, StepsCount stepsCount,
+                        BK4819_FilterBandwidth_t listenBw, ModulationMode_t modulation)
+{
+    if (center < F_MIN || center > F_MAX || scanStep > S_STEP_100_0kHz ||
+        stepsCount > STEPS_16 || listenBw > BK4819_FILTER_BW_NARROWER ||
+        modulation >= MODULATION_UKNOWN)
+    {
+        return false;
+    }
+
+    remote.center = center;
+    remote.scanStepIndex = scanStep;
+    remote.stepsCount = stepsCount;
+    remote.listenBw = listenBw;
+    remote.modulationType = modulation;
+
+    if (isInitialized)
+    {
+        ApplyRemoteSettings();
+    }
+    else
+    {
+        remoteStart = true;
+        gRequestSpectrum = true;
+    }
+    return true;
+}
+
+// leave as EXIT does, but without saving the settings
+void SPECTRUM_Exit()
+{
+    remoteStart = false;
+    gRequestSpectrum = false;
+    if (isInitialized)
+    {
+        DeInitSpectrum();
+    }
+}
+
+// a level of 0 keeps the one set; disarmed, peaks never stop the sweep
+void SPECTRUM_SetTrigger(uint16_t rssiTriggerLevel, bool armed)
+{
+    if (rssiTriggerLevel)
+    {
+        settings.rssiTriggerLevel = rssiTriggerLevel;
+    }
+    triggerArmed = armed;
+    redrawScreen = true;
+    redrawStatus = true;
+}
+
+// listen at f as the still view does, monitor keeps it open whatever the
+// trigger says; f of 0 goes back to sweeping
+bool SPECTRUM_Listen(uint32_t f, bool monitor)
+{
+    if (!isInitialized)
+    {
+        return false;
+    }
+
+    if (f == 0)
+    {
+        if (currentState != SPECTRUM)
+        {
+            SetState(SPECTRUM);
+            lockAGC = false;
+            monitorMode = false;
+            RelaunchScan();
+        }
+        return true;
+    }
+
+    if (f < F_MIN || f > F_MAX)
+    {
+        return false;
+    }
+
+    if (currentState != STILL)
+    {
+        SetState(STILL);
+    }
+    monitorMode = monitor;
+    SetF(f);
+    redrawScreen = true;
+    return true;
+}
+
+static uint16_t HistoryAt(int i, uint16_t count)
+{
+    if (i < 0 || i >= count || rssiHistory[i] == RSSI_MAX_VALUE)
+    {
+        return 0;
+    }
+    return rssiHistory[i];
+}
+
+// the strongest local maxima of the sweep at or above rssiMin, strongest
+// first
+uint8_t SPECTRUM_GetPeaks(SpectrumPeak *peaks, uint8_t max, uint16_t rssiMin)
+{
+    const uint16_t count = scanInfo.measurementsCount < 128 ? scanInfo.measurementsCount : 128;
+    const bool squeezed = scanInfo.measurementsCount > 128;
+    uint8_t found = 0;
+
+    if (!isInitialized || max == 0)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const uint16_t rssi = HistoryAt(i, count);
+
+        if (rssi == 0 || rssi < rssiMin || HistoryAt(i - 1, count) > rssi ||
+            HistoryAt(i + 1, count) >= rssi)
+        {
+            continue;
+        }
+
+        uint8_t j = found;
+        if (found < max)
+        {
+            found++;
+        }
+        else if (peaks[max - 1].rssi >= rssi)
+        {
+            continue;
+        }
+        else
+        {
+            j = max - 1;
+        }
+
+        while (j > 0 && peaks[j - 1].rssi < rssi)
+        {
+            peaks[j] = peaks[j - 1];
+            j--;
+        }
+
+        peaks[j].f = GetFStart() + (squeezed ? (uint32_t)i * GetBW() / 128 : (uint32_t)i * GetScanStep());
+        peaks[j].rssi = rssi;
+        peaks[j].i = i;
+    }
+
+    return found;
+}
+
+#endif
+
 void APP_RunSpectrum()
 {
     // TX here coz it always? set to active VFO
@@ -1551,6 +1820,14 @@ void APP_RunSpectrum()
 
     memset(rssiHistory, 0, sizeof(rssiHistory));
 
+#ifdef ENABLE_UART
+    if (remoteStart)
+    {
+        remoteStart = false;
+        ApplyRemoteSettings();
+    }
+#endif
+
     isInitialized = true;
 
     while (isInitialized)
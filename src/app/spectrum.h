@@ -184,6 +184,52 @@ typedef struct PeakInfo
 
 void APP_RunSpectrum(void);
 
+#ifdef ENABLE_UART
+
+// remote control over the programming cable, see app/uart.c; the
+// structs go out as they are
+
+#define SPECTRUM_PEAKS_MAX 16
+
+typedef struct SpectrumStatus
+{
+    uint32_t fStart, fEnd; // 10 Hz
+    uint32_t f;            // measured or listened to last
+    uint16_t scanStep;     // 10 Hz
+    uint16_t stepsCount;
+    uint16_t rssiTriggerLevel;
+    uint16_t sweeps;       // completed, wraps
+    uint8_t scanStepIndex; // ScanStep
+    uint8_t stepsCountIndex; // StepsCount
+    uint8_t listenBw;      // BK4819_FilterBandwidth_t
+    uint8_t modulationType; // ModulationMode_t
+    uint8_t state;         // State
+    bool running;
+    bool triggerArmed;
+    bool listening;
+    int8_t dBmCorrection;  // dBm = rssi / 2 - 160 + this
+    uint8_t padding[3];
+} SpectrumStatus;
+
+typedef struct SpectrumPeak
+{
+    uint32_t f;
+    uint16_t rssi;
+    uint16_t i;
+} SpectrumPeak;
+
+extern bool gRequestSpectrum;
+
+void SPECTRUM_GetStatus(SpectrumStatus *status);
+bool SPECTRUM_Configure(uint32_t center, ScanStep scanStep, StepsCount stepsCount,
+                        BK4819_FilterBandwidth_t listenBw, ModulationMode_t modulation);
+void SPECTRUM_Exit(void);
+void SPECTRUM_SetTrigger(uint16_t rssiTriggerLevel, bool armed);
+bool SPECTRUM_Listen(uint32_t f, bool monitor);
+uint8_t SPECTRUM_GetPeaks(SpectrumPeak *peaks, uint8_t max, uint16_t rssiMin);
+
+#endif
+
 #endif
 
 #endif /* ifndef SPECTRUM_H */
@@ -19,25 +19,103 @@
 #ifdef ENABLE_FMRADIO
     #include "app/fm.h"
 #endif
+#include "am_fix.h"
+#ifdef ENABLE_SPECTRUM
+    #include "app/spectrum.h"
+#endif
 #include "app/uart.h"
 #include "board.h"
 #include "bsp/dp32g030/dma.h"
 #include "bsp/dp32g030/gpio.h"
+#include "chcache.h"
 #include "driver/aes.h"
 #include "driver/backlight.h"
 #include "driver/bk4819.h"
 #include "driver/crc.h"
 #include "driver/eeprom.h"
 #include "driver/gpio.h"
+#include "driver/st7565.h"
 #include "driver/uart.h"
 #include "functions.h"
+#include "helper/battery.h"
+#include "helper/trace.h"
+#include "journal.h"
 #include "misc.h"
+#ifdef ENABLE_SCAN_LOG
+    #include "scanlog.h"
+#endif
 #include "settings.h"
 #include "version.h"
 
 #define UNUSED(x) (void)(x)
 
-#define DMA_INDEX(x, y) (((x) + (y)) % sizeof(UART_DMA_Buffer))
+#define DMA_INDEX(x, y) (((x) + (y)) % UART_RX_RING_SIZE)
+
+// largest frame, header and footer included: a frame filling the whole
+// ring would look like no data at all to the parser
+#define FRAME_MAX       (UART_RX_RING_SIZE - 1)
+
+// advertised in the version reply, in what used to be padding
+#define CAPS_MAGIC      0xC5
+#define CAP_BULK        0x01    // 0x0535 bulk read, 0x0537 bulk write
+#define CAP_BLOCK_CRC   0x02    // 0x0539 block CRCs
+#define CAP_BAUD_RATE   0x04    // 0x053B baud rate change
+#define CAP_FLOW        0x08    // 0x053D receive window
+#define CAP_TELEMETRY   0x10    // 0x053F telemetry stream
+#define CAP_REMOTE      0x20    // 0x0543 screen dump, 0x0545 key press
+#ifdef ENABLE_TRACE
+    #define CAP_TRACE   0x40    // 0x0548 trace records
+#else
+    #define CAP_TRACE   0
+#endif
+
+#if defined(ENABLE_SPECTRUM) && defined(ENABLE_UART)
+    #define CAP_SPECTRUM 0x80   // 0x0549 spectrum setup, 0x054B trigger, 0x054D peaks, 0x054F listen
+#else
+    #define CAP_SPECTRUM 0
+#endif
+
+// most trace records sent in one frame
+#define TRACE_BATCH     4
+
+// most scan log entries in one 0x0551 reply; the caps byte is full, so
+// hosts find out about 0x0551 by asking
+#define SCANLOG_BATCH   8
+
+// Largest bulk read. Commands run with interrupts off: the reply must fit
+// the transmit ring (256 bytes by default) so it is queued without waiting
+// for the wire, leaving only the ~3 ms it takes to read the EEPROM.
+#define BULK_READ_MAX   128
+// Most run length coded screen data in one 0x0544 reply, the rest of the
+// reply and the framing take 16 bytes. The same: commands run with
+// interrupts off, so the reply must fit the transmit ring.
+#define SCREEN_DATA_MAX (UART_TX_RING_SIZE - 1 - 16)
+// largest bulk write, a whole number of EEPROM pages that still fits a
+// command into the receive ring along with its header and framing, and
+// no more than the page cache holds: a bigger write would evict dirty
+// pages and wait out their burns while interrupts are off
+#define BULK_WRITE_FIT  (((FRAME_MAX - 8 - sizeof(CMD_0537_t)) / EEPROM_PAGE_SIZE) * EEPROM_PAGE_SIZE)
+#define BULK_WRITE_MAX  ((BULK_WRITE_FIT < EEPROM_CACHE_PAGES * EEPROM_PAGE_SIZE) ? BULK_WRITE_FIT : EEPROM_CACHE_PAGES * EEPROM_PAGE_SIZE)
+
+// EEPROM bytes covered by each CRC of a 0x0539 reply, and the most
+// blocks one request may ask for: interrupts are off while it counts,
+// 1 KiB of EEPROM takes ~25 ms to read
+#define CRC_BLOCK_SIZE  256
+#define CRC_BLOCKS_MAX  4
+
+// a new baud rate must be confirmed by a command arriving at that rate
+// within this time, otherwise the radio goes back to the default rate
+#define BAUD_CONFIRM_500ms  4
+
+// telemetry records go out no more often than this, leaving the link
+// room for commands, and stop unless the host subscribes again in time
+#define TELEMETRY_PERIOD_MIN    2       // 20 ms
+#define TELEMETRY_LEASE_500ms   60      // 30 s
+
+// an injected key is held down at least long enough to get through the
+// debounce, and is followed by a release before the next one is taken
+#define KEY_HOLD_MIN_10ms       5
+#define KEY_RELEASE_10ms        5
 
 typedef struct {
     uint16_t ID;
@@ -99,215 +177,1160 @@ typedef struct {
     } Data;
 } REPLY_051D_t;
 
-typedef struct {
-    Header_t Header;
-    struct {
-        uint16_t RSSI;
-        uint8_t  ExNoiseIndicator;
-        uint8_t  GlitchIndicator;
-    } Data;
-} REPLY_0527_t;
+typedef struct {
+    Header_t Header;
+    uint16_t Offset;
+    uint16_t Size;
+    uint32_t Timestamp;
+} CMD_0535_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t Offset;
+        uint16_t Size;
+    } Data;
+} REPLY_0535_t;
+
+typedef struct {
+    Header_t Header;
+    uint16_t Offset;
+    uint16_t Size;
+    bool     bAllowPassword;
+    uint8_t  Padding[3];
+    uint32_t Timestamp;
+    uint8_t  Data[0];
+} CMD_0537_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t Offset;
+        uint16_t Size;
+    } Data;
+} REPLY_0537_t;
+
+typedef struct {
+    Header_t Header;
+    uint16_t Offset;
+    uint16_t Count;
+    uint32_t Timestamp;
+} CMD_0539_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t Offset;
+        uint16_t Count;
+    } Data;
+    // followed by Count CRCs
+} REPLY_0539_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t BaudRate;
+    uint32_t Timestamp;
+} CMD_053B_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint32_t BaudRate;
+        bool     bAccepted;
+        uint8_t  Padding[3];
+    } Data;
+} REPLY_053B_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t Timestamp;
+} CMD_053D_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t RingSize;      // receive ring size
+        uint16_t Free;          // ring bytes free once this command is done
+        uint16_t CommandMax;    // largest command, framing not included
+        uint16_t BulkWriteMax;  // largest 0x0537 payload
+    } Data;
+} REPLY_053D_t;
+
+typedef struct {
+    Header_t Header;
+    uint16_t Period_10ms;   // 0 stops the stream
+    uint8_t  Padding[2];
+    uint32_t Timestamp;
+} CMD_053F_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t Period_10ms;   // as granted
+        uint8_t  Padding[2];
+    } Data;
+} REPLY_053F_t;
+
+// pushed unasked while subscribed
+typedef struct {
+    Header_t Header;
+    struct {
+        uint32_t Tick_10ms;         // time since boot
+        uint16_t Sequence;          // gaps tell of lost records
+        uint16_t RSSI;              // REG_67
+        uint8_t  ExNoiseIndicator;  // REG_65
+        uint8_t  GlitchIndicator;   // REG_63
+        uint8_t  AmFixIndex;        // AM fix gain table position
+        int8_t   RxGain_dB;
+        uint16_t Voltage;           // battery, 10 mV
+        uint8_t  Function;          // FUNCTION_Type_t
+        uint8_t  Padding;
+    } Data;
+} TELEMETRY_0542_t;
+
+typedef struct {
+    Header_t Header;
+    bool     bFull;         // every page, not just the changed ones
+    uint8_t  Padding[3];
+    uint32_t Timestamp;
+} CMD_0543_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint8_t Pages;      // bit n: page n follows, in page order
+        uint8_t Pending;    // bit n: page n changed but did not fit, ask again
+        uint8_t Padding[2];
+    } Data;
+    // followed by each page run length coded, see RleEncode()
+} REPLY_0543_t;
+
+typedef struct {
+    Header_t Header;
+    uint8_t  Key;           // KEY_Code_t, PTT not taken
+    uint8_t  Padding;
+    uint16_t Hold_10ms;
+    uint32_t Timestamp;
+} CMD_0545_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint8_t Key;
+        bool    bAccepted;  // false while the previous key is still busy
+        uint8_t Padding[2];
+    } Data;
+} REPLY_0545_t;
+
+#ifdef ENABLE_TRACE
+// pushed unasked while the link is idle
+typedef struct {
+    Header_t Header;
+    struct {
+        uint8_t        Count;   // records that follow
+        uint8_t        Padding[3];
+        TRACE_Record_t Records[TRACE_BATCH];
+    } Data;
+} TRACE_0548_t;
+#endif
+
+#if defined(ENABLE_SPECTRUM) && defined(ENABLE_UART)
+enum {
+    SPECTRUM_QUERY = 0,     // just the status
+    SPECTRUM_SET,           // sweep as given, starting the spectrum
+    SPECTRUM_EXIT,
+};
+
+typedef struct {
+    Header_t Header;
+    uint32_t Center;        // 10 Hz
+    uint8_t  Action;        // SPECTRUM_QUERY..
+    uint8_t  ScanStep;      // ScanStep
+    uint8_t  StepsCount;    // StepsCount, 128 >> n steps
+    uint8_t  ListenBw;      // BK4819_FilterBandwidth_t
+    uint8_t  Modulation;    // ModulationMode_t
+    uint8_t  Padding[3];
+    uint32_t Timestamp;
+} CMD_0549_t;
+
+// also the reply to 0x054B and 0x054F
+typedef struct {
+    Header_t       Header;
+    SpectrumStatus Data;
+} REPLY_0549_t;
+
+typedef struct {
+    Header_t Header;
+    uint16_t RssiTriggerLevel;  // 0 keeps the level
+    bool     bArmed;
+    uint8_t  Padding;
+    uint32_t Timestamp;
+} CMD_054B_t;
+
+typedef struct {
+    Header_t Header;
+    uint8_t  Max;           // peaks wanted
+    uint8_t  Padding;
+    uint16_t RssiMin;
+    uint32_t Timestamp;
+} CMD_054D_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t     Sweeps;    // the peaks are from this many sweeps in
+        uint8_t      Count;     // peaks that follow, strongest first
+        uint8_t      Padding;
+        SpectrumPeak Peaks[SPECTRUM_PEAKS_MAX];
+    } Data;
+} REPLY_054D_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t Frequency;     // 10 Hz, 0 goes back to sweeping
+    bool     bMonitor;      // listen whatever the trigger says
+    uint8_t  Padding[3];
+    uint32_t Timestamp;
+} CMD_054F_t;
+#endif
+
+#ifdef ENABLE_SCAN_LOG
+typedef struct {
+    Header_t Header;
+    uint16_t First;         // number of the first hit wanted
+    uint8_t  Max;           // hits wanted
+    uint8_t  Padding;
+    uint32_t Timestamp;
+} CMD_0551_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint32_t        Tick_10ms;  // now, to put the hits in time
+        uint16_t        First;      // number of Entries[0]
+        uint16_t        Next;       // number the next hit will get
+        uint16_t        BootFirst;  // hits before this are from an earlier boot
+        uint8_t         Count;      // entries that follow, oldest first
+        uint8_t         Padding;
+        SCANLOG_Entry_t Entries[SCANLOG_BATCH];
+    } Data;
+} REPLY_0551_t;
+#endif
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t RSSI;
+        uint8_t  ExNoiseIndicator;
+        uint8_t  GlitchIndicator;
+    } Data;
+} REPLY_0527_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t Voltage;
+        uint16_t Current;
+    } Data;
+} REPLY_0529_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t Response[4];
+} CMD_052D_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        bool bIsLocked;
+        uint8_t Padding[3];
+    } Data;
+} REPLY_052D_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t Timestamp;
+} CMD_052F_t;
+
+static const uint8_t Obfuscation[16] =
+{
+    0x16, 0x6C, 0x14, 0xE6, 0x2E, 0x91, 0x0D, 0x40, 0x21, 0x35, 0xD5, 0x40, 0x13, 0x03, 0xE9, 0x80
+};
+
+// A command left in place in the DMA ring, see View_Read()
+typedef struct {
+    uint16_t Start;     // ring index of its first byte (the ID)
+    uint16_t Size;      // its bytes, CRC not included
+} CommandView_t;
+
+static CommandView_t gCommand;
+
+// frame parser state, kept between calls
+static uint16_t gFrameIndex;    // ring index of the frame being looked at
+static bool     gFrameFound;    // an 0xAB 0xCD header sits at gFrameIndex
+
+static uint32_t Timestamp;
+static uint32_t gBaudRate = UART_BAUD_RATE_DEFAULT;
+static uint8_t  gBaudConfirmCountdown_500ms;
+static uint16_t gTelemetryPeriod_10ms;
+static uint16_t gTelemetryCountdown_10ms;
+static uint16_t gTelemetrySequence;
+static uint8_t  gTelemetryLease_500ms;
+static uint16_t gScreenCrc[FRAME_LINES];   // of each page as last dumped
+static bool     gScreenCrcValid;
+static uint8_t  gScreenPending;             // pages changed but not sent yet
+static uint8_t  gInjectedKey = KEY_INVALID;
+static uint16_t gKeyHold_10ms;
+static uint8_t  gKeyRelease_10ms;
+static bool     bIsEncrypted = true;
+
+// Copy Size bytes from Offset into a frame body starting at ring index
+// Start, undoing the obfuscation on the way.
+static void RingRead(uint16_t Start, uint16_t Offset, void *pBuffer, uint16_t Size)
+{
+    uint8_t *pBytes = (uint8_t *)pBuffer;
+
+    for (uint16_t i = 0; i < Size; i++)
+    {
+        const uint8_t Byte = UART_DMA_Buffer[DMA_INDEX(Start, Offset + i)];
+        pBytes[i] = bIsEncrypted ? Byte ^ Obfuscation[(Offset + i) % 16] : Byte;
+    }
+}
+
+// Copy part of a command out of the ring. Bytes past its end read as 0,
+// so a short command can't hand a handler stale data.
+static void View_Read(const CommandView_t *pView, uint16_t Offset, void *pBuffer, uint16_t Size)
+{
+    uint16_t n = 0;
+
+    if (Offset < pView->Size)
+        n = (Size < pView->Size - Offset) ? Size : pView->Size - Offset;
+
+    RingRead(pView->Start, Offset, pBuffer, n);
+    memset((uint8_t *)pBuffer + n, 0, Size - n);
+}
+
+// the fixed part of a command, as the struct describing it
+static const void *View_Fetch(const CommandView_t *pView, void *pBuffer, uint16_t Size)
+{
+    View_Read(pView, 0, pBuffer, Size);
+    return pBuffer;
+}
+
+static uint16_t View_ID(const CommandView_t *pView)
+{
+    uint16_t ID;
+    View_Read(pView, 0, &ID, sizeof(ID));
+    return ID;
+}
+
+static uint16_t gReplyIndex;
+
+// A reply goes out in pieces: ReplyBegin() with the total size, any number
+// of ReplyData() and ReplyEnd(). This lets large replies be sent straight
+// from the EEPROM without a buffer for the whole of them.
+static void ReplyBegin(uint16_t Size)
+{
+    Header_t Header;
+
+    Header.ID = 0xCDAB;
+    Header.Size = Size;
+    UART_Send(&Header, sizeof(Header));
+
+    gReplyIndex = 0;
+}
+
+static void ReplyData(const void *pData, uint16_t Size)
+{
+    const uint8_t *pBytes = (const uint8_t *)pData;
+    uint8_t        Buffer[16];
+
+    while (Size > 0)
+    {
+        const uint16_t n = (Size < sizeof(Buffer)) ? Size : sizeof(Buffer);
+        unsigned int   i;
+
+        for (i = 0; i < n; i++)
+            Buffer[i] = bIsEncrypted ? pBytes[i] ^ Obfuscation[(gReplyIndex + i) % 16] : pBytes[i];
+
+        UART_Send(Buffer, n);
+
+        gReplyIndex += n;
+        pBytes      += n;
+        Size        -= n;
+    }
+}
+
+static void ReplyEnd(void)
+{
+    Footer_t Footer;
+
+    if (bIsEncrypted)
+    {
+        Footer.Padding[0] = Obfuscation[(gReplyIndex + 0) % 16] ^ 0xFF;
+        Footer.Padding[1] = Obfuscation[(gReplyIndex + 1) % 16] ^ 0xFF;
+    }
+    else
+    {
+        Footer.Padding[0] = 0xFF;
+        Footer.Padding[1] = 0xFF;
+    }
+    Footer.ID = 0xBADC;
+
+    UART_Send(&Footer, sizeof(Footer));
+}
+
+static void SendReply(const void *pReply, uint16_t Size)
+{
+    ReplyBegin(Size);
+    ReplyData(pReply, Size);
+    ReplyEnd();
+}
+
+static void SendVersion(void)
+{
+    REPLY_0514_t Reply;
+
+    Reply.Header.ID = 0x0515;
+    Reply.Header.Size = sizeof(Reply.Data);
+    strcpy(Reply.Data.Version, Version);
+    Reply.Data.bHasCustomAesKey = bHasCustomAesKey;
+    Reply.Data.bIsInLockScreen = bIsInLockScreen;
+    Reply.Data.Padding[0] = CAPS_MAGIC;
+    Reply.Data.Padding[1] = CAP_BULK | CAP_BLOCK_CRC | CAP_BAUD_RATE | CAP_FLOW | CAP_TELEMETRY | CAP_REMOTE | CAP_TRACE | CAP_SPECTRUM;
+    Reply.Data.Challenge[0] = gChallenge[0];
+    Reply.Data.Challenge[1] = gChallenge[1];
+    Reply.Data.Challenge[2] = gChallenge[2];
+    Reply.Data.Challenge[3] = gChallenge[3];
+
+    SendReply(&Reply, sizeof(Reply));
+}
+
+static bool IsBadChallenge(const uint32_t *pKey, const uint32_t *pIn, const uint32_t *pResponse)
+{
+    UNUSED(pKey);
+    UNUSED(pIn);
+    UNUSED(pResponse);
+    return false;
+}
+
+// session init, sends back version info and state
+// timestamp is a session id really
+static void CMD_0514(const CommandView_t *pView)
+{
+    CMD_0514_t        Cmd;
+    const CMD_0514_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+
+    Timestamp = pCmd->Timestamp;
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    // a new session, whoever subscribed to telemetry is gone
+    gTelemetryPeriod_10ms = 0;
+    
+    // turn the LCD backlight off
+    BACKLIGHT_TurnOff();
+
+    SendVersion();
+}
+
+// the range covers EEPROM the VFO state journal stands in for
+static bool IsJournaled(uint16_t Offset, uint16_t Size)
+{
+    const uint32_t end = (uint32_t)Offset + Size;
+    return (Offset < 0x0D60 && end > 0x0C80) ||   // VFO records
+           (Offset < 0x0E88 && end > 0x0E80) ||   // VFO indices
+           (Offset < 0x1E00 && end > 0x1D00);     // the journal itself
+}
+
+// read eeprom
+static void CMD_051B(const CommandView_t *pView)
+{
+    CMD_051B_t        Cmd;
+    const CMD_051B_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_051B_t      Reply;
+    bool              bLocked = false;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID   = 0x051C;
+    Reply.Header.Size = pCmd->Size + 4;
+    Reply.Data.Offset = pCmd->Offset;
+    Reply.Data.Size   = pCmd->Size;
+
+    if (bHasCustomAesKey)
+        bLocked = gIsLocked;
+
+    if (!bLocked) {
+        // the host reads what a save pending in RAM would write
+        SETTINGS_CommitSettings();
+        if (IsJournaled(pCmd->Offset, pCmd->Size))
+            JOURNAL_Fold();
+        EEPROM_ReadBuffer(pCmd->Offset, Reply.Data.Data, pCmd->Size);
+    }
+
+    SendReply(&Reply, pCmd->Size + 8);
+}
+
+// write whole 8 byte blocks from the programming software, the pages
+// they land in are gathered in the EEPROM cache and burnt once each
+static void WriteEeprom(uint16_t Offset, const CommandView_t *pView, uint16_t DataOffset, uint16_t Size, bool bAllowPassword)
+{
+    bool         bReloadEeprom = false;
+    unsigned int i;
+
+    // land our own pending settings first, the host has the last word
+    SETTINGS_CommitSettings();
+    if (IsJournaled(Offset, Size))
+        JOURNAL_Fold();
+
+    for (i = 0; i < (Size / 8); i++)
+    {
+        const uint16_t Address = Offset + (i * 8U);
+        uint8_t        Data[8];
+
+        if (Address >= 0x0F30 && Address < 0x0F40)
+            if (!gIsLocked)
+                bReloadEeprom = true;
+
+        if ((Address < 0x0E98 || Address >= 0x0EA0) || !bIsInLockScreen || bAllowPassword)
+        {
+            View_Read(pView, DataOffset + (i * 8U), Data, sizeof(Data));
+            EEPROM_WriteBuffer(Address, Data);
+        }
+    }
+
+    CHCACHE_InvalidateRange(Offset, Size);
+    if (IsJournaled(Offset, Size))
+        JOURNAL_Reset();
+    if (SETTINGS_IsSettingsBlock(Offset, Size))
+        SETTINGS_SealSettings();
+
+    if (bReloadEeprom)
+        SETTINGS_InitEEPROM();
+}
+
+// write eeprom
+static void CMD_051D(const CommandView_t *pView)
+{
+    CMD_051D_t Cmd;
+    const CMD_051D_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_051D_t Reply;
+    bool bIsLocked;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    Reply.Header.ID   = 0x051E;
+    Reply.Header.Size = sizeof(Reply.Data);
+    Reply.Data.Offset = pCmd->Offset;
+
+    bIsLocked = bHasCustomAesKey ? gIsLocked : bHasCustomAesKey;
+
+    if (!bIsLocked)
+        WriteEeprom(pCmd->Offset, pView, sizeof(Cmd), pCmd->Size, pCmd->bAllowPassword);
+
+    SendReply(&Reply, sizeof(Reply));
+}
+
+// bulk read eeprom, the data is streamed out as it comes in
+static void CMD_0535(const CommandView_t *pView)
+{
+    CMD_0535_t        Cmd;
+    const CMD_0535_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_0535_t      Reply;
+    uint8_t           Buffer[32];
+    uint16_t          Size;
+    uint16_t          Left;
+    bool              bLocked = false;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    Size = pCmd->Size;
+    if (Size > BULK_READ_MAX)
+        Size = BULK_READ_MAX;
+    if (pCmd->Offset + (uint32_t)Size > gEepromSize)
+        Size = (pCmd->Offset < gEepromSize) ? gEepromSize - pCmd->Offset : 0;
+
+    Reply.Header.ID   = 0x0536;
+    Reply.Header.Size = Size + 4;
+    Reply.Data.Offset = pCmd->Offset;
+    Reply.Data.Size   = Size;
+
+    if (bHasCustomAesKey)
+        bLocked = gIsLocked;
+
+    if (!bLocked && Size > 0)
+    {
+        // the host reads what a save pending in RAM would write
+        SETTINGS_CommitSettings();
+        if (IsJournaled(pCmd->Offset, Size))
+            JOURNAL_Fold();
+    }
+
+    ReplyBegin(sizeof(Reply) + Size);
+    ReplyData(&Reply, sizeof(Reply));
+
+    if (bLocked)
+        memset(Buffer, 0, sizeof(Buffer));
+    else
+        EEPROM_StreamBegin(pCmd->Offset, Size);
+
+    for (Left = Size; Left > 0; )
+    {
+        const uint16_t n = (Left < sizeof(Buffer)) ? Left : sizeof(Buffer);
+
+        if (!bLocked)
+            EEPROM_StreamRead(Buffer, n);
+        ReplyData(Buffer, n);
+
+        Left -= n;
+    }
+
+    ReplyEnd();
+}
+
+// bulk write eeprom
+static void CMD_0537(const CommandView_t *pView)
+{
+    CMD_0537_t        Cmd;
+    const CMD_0537_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_0537_t      Reply;
+    uint16_t          Size;
+    bool              bIsLocked;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    // never trust the size over what actually arrived
+    Size = pCmd->Size;
+    if (Size > BULK_WRITE_MAX)
+        Size = BULK_WRITE_MAX;
+    if (pView->Size < sizeof(Cmd))
+        Size = 0;
+    else if (Size > pView->Size - sizeof(Cmd))
+        Size = pView->Size - sizeof(Cmd);
+    Size &= ~7U;
+
+    Reply.Header.ID   = 0x0538;
+    Reply.Header.Size = sizeof(Reply.Data);
+    Reply.Data.Offset = pCmd->Offset;
+    Reply.Data.Size   = 0;
+
+    bIsLocked = bHasCustomAesKey ? gIsLocked : bHasCustomAesKey;
+
+    if (!bIsLocked)
+    {
+        WriteEeprom(pCmd->Offset, pView, sizeof(Cmd), Size, pCmd->bAllowPassword);
+        Reply.Data.Size = Size;
+    }
+
+    SendReply(&Reply, sizeof(Reply));
+}
+
+// CRC16 of each 256 byte EEPROM block, lets the programming software
+// upload only the blocks that differ from its image
+static void CMD_0539(const CommandView_t *pView)
+{
+    CMD_0539_t        Cmd;
+    const CMD_0539_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_0539_t      Reply;
+    uint8_t           Buffer[32];
+    uint16_t          Count;
+    bool              bLocked = false;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    if (bHasCustomAesKey)
+        bLocked = gIsLocked;
+
+    Count = pCmd->Count;
+    if (Count > CRC_BLOCKS_MAX)
+        Count = CRC_BLOCKS_MAX;
+    if (bLocked || (pCmd->Offset % CRC_BLOCK_SIZE) != 0 || pCmd->Offset >= gEepromSize)
+        Count = 0;
+    else if (pCmd->Offset + (uint32_t)Count * CRC_BLOCK_SIZE > gEepromSize)
+        Count = (gEepromSize - pCmd->Offset) / CRC_BLOCK_SIZE;
+
+    Reply.Header.ID   = 0x053A;
+    Reply.Header.Size = sizeof(Reply.Data) + Count * 2;
+    Reply.Data.Offset = pCmd->Offset;
+    Reply.Data.Count  = Count;
+
+    ReplyBegin(sizeof(Reply) + Count * 2);
+    ReplyData(&Reply, sizeof(Reply));
+
+    if (Count > 0)
+    {
+        // the CRCs must describe what the host would read back
+        SETTINGS_CommitSettings();
+        if (IsJournaled(pCmd->Offset, Count * CRC_BLOCK_SIZE))
+            JOURNAL_Fold();
+    }
+
+    for (uint16_t Block = 0; Block < Count; Block++)
+    {
+        uint16_t Crc;
+
+        EEPROM_StreamBegin(pCmd->Offset + Block * CRC_BLOCK_SIZE, CRC_BLOCK_SIZE);
+
+        CRC_Begin();
+        for (unsigned int i = 0; i < CRC_BLOCK_SIZE / sizeof(Buffer); i++)
+        {
+            EEPROM_StreamRead(Buffer, sizeof(Buffer));
+            CRC_Update(Buffer, sizeof(Buffer));
+        }
+        Crc = CRC_End();
+
+        ReplyData(&Crc, sizeof(Crc));
+    }
+
+    ReplyEnd();
+}
+
+// change the baud rate, the reply still goes out at the old one
+static void CMD_053B(const CommandView_t *pView)
+{
+    CMD_053B_t        Cmd;
+    const CMD_053B_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_053B_t      Reply;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID     = 0x053C;
+    Reply.Header.Size   = sizeof(Reply.Data);
+    Reply.Data.BaudRate = pCmd->BaudRate;
+
+    switch (pCmd->BaudRate)
+    {
+        case 38400:
+        case 57600:
+        case 115200:
+        case 230400:
+            Reply.Data.bAccepted = true;
+            break;
+        default:
+            Reply.Data.bAccepted = false;
+            Reply.Data.BaudRate  = gBaudRate;
+            break;
+    }
+
+    SendReply(&Reply, sizeof(Reply));
+
+    if (!Reply.Data.bAccepted || pCmd->BaudRate == gBaudRate)
+        return;
+
+    UART_SetBaudRate(pCmd->BaudRate);
+    gBaudRate                   = pCmd->BaudRate;
+    gBaudConfirmCountdown_500ms = (gBaudRate == UART_BAUD_RATE_DEFAULT) ? 0 : BAUD_CONFIRM_500ms;
+}
+
+// Receive window. Each command stays in the ring until its reply has been
+// queued, so a host keeping the frames it has sent without a reply under
+// RingSize - 1 bytes can send ahead without ever overrunning the ring.
+static void CMD_053D(const CommandView_t *pView)
+{
+    CMD_053D_t        Cmd;
+    const CMD_053D_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_053D_t      Reply;
+    const uint16_t    End = DMA_INDEX(pView->Start, pView->Size + 4);
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    Reply.Header.ID         = 0x053E;
+    Reply.Header.Size       = sizeof(Reply.Data);
+    Reply.Data.RingSize     = UART_RX_RING_SIZE;
+    Reply.Data.Free         = FRAME_MAX - DMA_INDEX(UART_RxIndex() + UART_RX_RING_SIZE - End, 0);
+    Reply.Data.CommandMax   = FRAME_MAX - 8;
+    Reply.Data.BulkWriteMax = BULK_WRITE_MAX;
+
+    SendReply(&Reply, sizeof(Reply));
+}
+
+// subscribe to the telemetry stream, or leave it with a period of 0
+static void CMD_053F(const CommandView_t *pView)
+{
+    CMD_053F_t        Cmd;
+    const CMD_053F_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_053F_t      Reply;
+    uint16_t          Period = pCmd->Period_10ms;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    if (Period != 0 && Period < TELEMETRY_PERIOD_MIN)
+        Period = TELEMETRY_PERIOD_MIN;
 
-typedef struct {
-    Header_t Header;
-    struct {
-        uint16_t Voltage;
-        uint16_t Current;
-    } Data;
-} REPLY_0529_t;
+    // a renewal keeps the phase of the running stream
+    if (Period != gTelemetryPeriod_10ms)
+        gTelemetryCountdown_10ms = Period;
 
-typedef struct {
-    Header_t Header;
-    uint32_t Response[4];
-} CMD_052D_t;
+    gTelemetryPeriod_10ms = Period;
+    gTelemetryLease_500ms = TELEMETRY_LEASE_500ms;
 
-typedef struct {
-    Header_t Header;
-    struct {
-        bool bIsLocked;
-        uint8_t Padding[3];
-    } Data;
-} REPLY_052D_t;
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID        = 0x0540;
+    Reply.Header.Size      = sizeof(Reply.Data);
+    Reply.Data.Period_10ms = Period;
 
-typedef struct {
-    Header_t Header;
-    uint32_t Timestamp;
-} CMD_052F_t;
+    SendReply(&Reply, sizeof(Reply));
+}
 
-static const uint8_t Obfuscation[16] =
+static void SendTelemetry(void)
 {
-    0x16, 0x6C, 0x14, 0xE6, 0x2E, 0x91, 0x0D, 0x40, 0x21, 0x35, 0xD5, 0x40, 0x13, 0x03, 0xE9, 0x80
-};
+    TELEMETRY_0542_t Record;
+
+    Record.Header.ID             = 0x0542;
+    Record.Header.Size           = sizeof(Record.Data);
+    Record.Data.Tick_10ms        = gGlobalSysTickCounter;
+    Record.Data.Sequence         = gTelemetrySequence++;
+    Record.Data.RSSI             = BK4819_ReadRegister(BK4819_REG_67) & 0x01FF;
+    Record.Data.ExNoiseIndicator = BK4819_ReadRegister(BK4819_REG_65) & 0x007F;
+    Record.Data.GlitchIndicator  = BK4819_ReadRegister(BK4819_REG_63);
+    Record.Data.AmFixIndex       = AM_fix_get_gain_index(gEeprom.RX_VFO);
+    Record.Data.RxGain_dB        = BK4819_GetRxGain_dB();
+    Record.Data.Voltage          = gBatteryVoltageAverage;
+    Record.Data.Function         = gCurrentFunction;
+    Record.Data.Padding          = 0;
+
+    SendReply(&Record, sizeof(Record));
+}
 
-static union
+#ifdef ENABLE_TRACE
+static void SendTrace(void)
 {
-    uint8_t Buffer[256];
-    struct
-    {
-        Header_t Header;
-        uint8_t Data[252];
-    };
-} UART_Command;
+    TRACE_0548_t Trace;
+    uint8_t      Count = 0;
 
-static uint32_t Timestamp;
-static uint16_t gUART_WriteIndex;
-static bool     bIsEncrypted = true;
+    while (Count < TRACE_BATCH && TRACE_Fetch(&Trace.Data.Records[Count]))
+        Count++;
 
-static void SendReply(void *pReply, uint16_t Size)
+    if (Count == 0)
+        return;
+
+    const uint16_t Size = sizeof(Trace) - (TRACE_BATCH - Count) * sizeof(TRACE_Record_t);
+
+    Trace.Header.ID       = 0x0548;
+    Trace.Header.Size     = Size - sizeof(Trace.Header);
+    Trace.Data.Count      = Count;
+    Trace.Data.Padding[0] = 0;
+    Trace.Data.Padding[1] = 0;
+    Trace.Data.Padding[2] = 0;
+
+    SendReply(&Trace, Size);
+}
+#endif
+
+// Run length code Size bytes: a control byte below 0x80 is followed by
+// that many plus one bytes as they are, one from 0x80 up by a byte that
+// repeats (control - 0x80 + 3) times. Returns the coded size, and sends
+// the code as reply data when bSend.
+static uint16_t RleEncode(const uint8_t *pData, uint16_t Size, bool bSend)
 {
-    Header_t Header;
-    Footer_t Footer;
+    uint16_t Coded = 0;
+    uint16_t i     = 0;
 
-    if (bIsEncrypted)
+    while (i < Size)
     {
-        uint8_t     *pBytes = (uint8_t *)pReply;
-        unsigned int i;
-        for (i = 0; i < Size; i++)
-            pBytes[i] ^= Obfuscation[i % 16];
+        uint16_t Run = 1;
+        uint8_t  Code;
+
+        while (i + Run < Size && Run < 130 && pData[i + Run] == pData[i])
+            Run++;
+
+        if (Run >= 3)
+        {
+            Code = 0x80 + (Run - 3);
+            if (bSend)
+            {
+                ReplyData(&Code, 1);
+                ReplyData(&pData[i], 1);
+            }
+            Coded += 2;
+            i     += Run;
+            continue;
+        }
+
+        // bytes as they are, up to where a run worth coding starts
+        for (Run = 1; i + Run < Size && Run < 128; Run++)
+            if (i + Run + 2 < Size && pData[i + Run] == pData[i + Run + 1] && pData[i + Run] == pData[i + Run + 2])
+                break;
+
+        Code = Run - 1;
+        if (bSend)
+        {
+            ReplyData(&Code, 1);
+            ReplyData(&pData[i], Run);
+        }
+        Coded += 1 + Run;
+        i     += Run;
     }
 
-    Header.ID = 0xCDAB;
-    Header.Size = Size;
-    UART_Send(&Header, sizeof(Header));
-    UART_Send(pReply, Size);
+    return Coded;
+}
 
-    if (bIsEncrypted)
+// a page coded at its worst, bytes as they are in runs of up to 128
+_Static_assert(SCREEN_DATA_MAX >= LCD_WIDTH + (LCD_WIDTH + 127) / 128, "screen page does not fit a reply");
+
+// screen dump, only the pages that changed since the last one unless the
+// host asks for all of them, and of those only what fits the transmit ring
+static void CMD_0543(const CommandView_t *pView)
+{
+    CMD_0543_t        Cmd;
+    const CMD_0543_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_0543_t      Reply;
+    uint16_t          Size = 0;
+    uint8_t           Page;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    memset(&Reply, 0, sizeof(Reply));
+
+    for (Page = 0; Page < FRAME_LINES; Page++)
     {
-        Footer.Padding[0] = Obfuscation[(Size + 0) % 16] ^ 0xFF;
-        Footer.Padding[1] = Obfuscation[(Size + 1) % 16] ^ 0xFF;
+        const uint16_t Crc = CRC_Calculate(gFrameBuffer[Page], LCD_WIDTH);
+
+        if (pCmd->bFull || !gScreenCrcValid || Crc != gScreenCrc[Page])
+            gScreenPending |= 1u << Page;
+        gScreenCrc[Page] = Crc;
     }
-    else
+    gScreenCrcValid = true;
+
+    // the first pending page always fits, the others as long as they do
+    for (Page = 0; Page < FRAME_LINES; Page++)
     {
-        Footer.Padding[0] = 0xFF;
-        Footer.Padding[1] = 0xFF;
-    }
-    Footer.ID = 0xBADC;
+        if (!(gScreenPending & (1u << Page)))
+            continue;
 
-    UART_Send(&Footer, sizeof(Footer));
+        const uint16_t Coded = RleEncode(gFrameBuffer[Page], LCD_WIDTH, false);
+
+        if (Size + Coded <= SCREEN_DATA_MAX)
+        {
+            Reply.Data.Pages |= 1u << Page;
+            Size             += Coded;
+        }
+    }
+    gScreenPending    &= ~Reply.Data.Pages;
+    Reply.Data.Pending = gScreenPending;
+
+    Reply.Header.ID   = 0x0544;
+    Reply.Header.Size = sizeof(Reply.Data) + Size;
+
+    ReplyBegin(sizeof(Reply) + Size);
+    ReplyData(&Reply, sizeof(Reply));
+    for (Page = 0; Page < FRAME_LINES; Page++)
+        if (Reply.Data.Pages & (1u << Page))
+            RleEncode(gFrameBuffer[Page], LCD_WIDTH, true);
+    ReplyEnd();
 }
 
-static void SendVersion(void)
+// press a key for a while, CheckKeys() sees it as if it came from the
+// keypad so held keys and repeats work as usual
+static void CMD_0545(const CommandView_t *pView)
 {
-    REPLY_0514_t Reply;
+    CMD_0545_t        Cmd;
+    const CMD_0545_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_0545_t      Reply;
 
-    Reply.Header.ID = 0x0515;
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID   = 0x0546;
     Reply.Header.Size = sizeof(Reply.Data);
-    strcpy(Reply.Data.Version, Version);
-    Reply.Data.bHasCustomAesKey = bHasCustomAesKey;
-    Reply.Data.bIsInLockScreen = bIsInLockScreen;
-    Reply.Data.Challenge[0] = gChallenge[0];
-    Reply.Data.Challenge[1] = gChallenge[1];
-    Reply.Data.Challenge[2] = gChallenge[2];
-    Reply.Data.Challenge[3] = gChallenge[3];
+    Reply.Data.Key    = pCmd->Key;
+
+    // no transmitting from afar: PTT is refused here, and whatever a side
+    // key is mapped to cannot key up while UART_IsKeyInjected() holds
+    if (pCmd->Key < KEY_INVALID && pCmd->Key != KEY_PTT && gKeyHold_10ms == 0 && gKeyRelease_10ms == 0)
+    {
+        gInjectedKey         = pCmd->Key;
+        gKeyHold_10ms        = (pCmd->Hold_10ms < KEY_HOLD_MIN_10ms) ? KEY_HOLD_MIN_10ms : pCmd->Hold_10ms;
+        Reply.Data.bAccepted = true;
+    }
 
     SendReply(&Reply, sizeof(Reply));
 }
 
-static bool IsBadChallenge(const uint32_t *pKey, const uint32_t *pIn, const uint32_t *pResponse)
+KEY_Code_t UART_InjectedKey(void)
 {
-    UNUSED(pKey);
-    UNUSED(pIn);
-    UNUSED(pResponse);
-    return false;
+    return (gKeyHold_10ms > 0) ? (KEY_Code_t)gInjectedKey : KEY_INVALID;
 }
 
-// session init, sends back version info and state
-// timestamp is a session id really
-static void CMD_0514(const uint8_t *pBuffer)
+// true from the press of an injected key until its release has been handled
+bool UART_IsKeyInjected(void)
 {
-    const CMD_0514_t *pCmd = (const CMD_0514_t *)pBuffer;
+    return gKeyHold_10ms > 0 || gKeyRelease_10ms > 0;
+}
 
-    Timestamp = pCmd->Timestamp;
+#if defined(ENABLE_SPECTRUM) && defined(ENABLE_UART)
+static void SendSpectrumStatus(uint16_t ID)
+{
+    REPLY_0549_t Reply;
 
-    #ifdef ENABLE_FMRADIO
-        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
-    #endif
+    Reply.Header.ID   = ID;
+    Reply.Header.Size = sizeof(Reply.Data);
+    SPECTRUM_GetStatus(&Reply.Data);
 
-    gSerialConfigCountDown_500ms = 12; // 6 sec
-    
-    // turn the LCD backlight off
-    BACKLIGHT_TurnOff();
+    SendReply(&Reply, sizeof(Reply));
+}
 
-    SendVersion();
+// set up the spectrum sweep, which starts the spectrum from the main
+// loop when it is not running, or leave it; the reply is the status
+// before any start
+static void CMD_0549(const CommandView_t *pView)
+{
+    CMD_0549_t        Cmd;
+    const CMD_0549_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    if (pCmd->Action == SPECTRUM_SET)
+        SPECTRUM_Configure(pCmd->Center, pCmd->ScanStep, pCmd->StepsCount, pCmd->ListenBw, pCmd->Modulation);
+    else if (pCmd->Action == SPECTRUM_EXIT)
+        SPECTRUM_Exit();
+
+    SendSpectrumStatus(0x054A);
 }
 
-// read eeprom
-static void CMD_051B(const uint8_t *pBuffer)
+static void CMD_054B(const CommandView_t *pView)
 {
-    const CMD_051B_t *pCmd = (const CMD_051B_t *)pBuffer;
-    REPLY_051B_t      Reply;
-    bool              bLocked = false;
+    CMD_054B_t        Cmd;
+    const CMD_054B_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
 
     if (pCmd->Timestamp != Timestamp)
         return;
 
-    gSerialConfigCountDown_500ms = 12; // 6 sec
+    SPECTRUM_SetTrigger(pCmd->RssiTriggerLevel, pCmd->bArmed);
 
-    #ifdef ENABLE_FMRADIO
-        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
-    #endif
+    SendSpectrumStatus(0x054C);
+}
+
+static void CMD_054D(const CommandView_t *pView)
+{
+    CMD_054D_t        Cmd;
+    const CMD_054D_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_054D_t      Reply;
+    SpectrumStatus    Status;
+
+    if (pCmd->Timestamp != Timestamp)
+        return;
+
+    const uint8_t Max = (pCmd->Max < SPECTRUM_PEAKS_MAX) ? pCmd->Max : SPECTRUM_PEAKS_MAX;
+
+    SPECTRUM_GetStatus(&Status);
 
     memset(&Reply, 0, sizeof(Reply));
-    Reply.Header.ID   = 0x051C;
-    Reply.Header.Size = pCmd->Size + 4;
-    Reply.Data.Offset = pCmd->Offset;
-    Reply.Data.Size   = pCmd->Size;
+    Reply.Data.Sweeps = Status.sweeps;
+    Reply.Data.Count  = SPECTRUM_GetPeaks(Reply.Data.Peaks, Max, pCmd->RssiMin);
 
-    if (bHasCustomAesKey)
-        bLocked = gIsLocked;
+    const uint16_t Size = sizeof(Reply) - (SPECTRUM_PEAKS_MAX - Reply.Data.Count) * sizeof(SpectrumPeak);
 
-    if (!bLocked)
-        EEPROM_ReadBuffer(pCmd->Offset, Reply.Data.Data, pCmd->Size);
+    Reply.Header.ID   = 0x054E;
+    Reply.Header.Size = Size - sizeof(Reply.Header);
 
-    SendReply(&Reply, pCmd->Size + 8);
+    SendReply(&Reply, Size);
 }
 
-// write eeprom
-static void CMD_051D(const uint8_t *pBuffer)
+static void CMD_054F(const CommandView_t *pView)
 {
-    const CMD_051D_t *pCmd = (const CMD_051D_t *)pBuffer;
-    REPLY_051D_t Reply;
-    bool bReloadEeprom;
-    bool bIsLocked;
+    CMD_054F_t        Cmd;
+    const CMD_054F_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
 
     if (pCmd->Timestamp != Timestamp)
         return;
 
-    gSerialConfigCountDown_500ms = 12; // 6 sec
-    
-    bReloadEeprom = false;
+    SPECTRUM_Listen(pCmd->Frequency, pCmd->bMonitor);
 
-    #ifdef ENABLE_FMRADIO
-        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
-    #endif
+    SendSpectrumStatus(0x0550);
+}
+#endif
 
-    Reply.Header.ID   = 0x051E;
-    Reply.Header.Size = sizeof(Reply.Data);
-    Reply.Data.Offset = pCmd->Offset;
+#ifdef ENABLE_SCAN_LOG
+// read the scan log from hit First on, or from the oldest one still kept
+// when First is gone already
+static void CMD_0551(const CommandView_t *pView)
+{
+    CMD_0551_t        Cmd;
+    const CMD_0551_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
+    REPLY_0551_t      Reply;
 
-    bIsLocked = bHasCustomAesKey ? gIsLocked : bHasCustomAesKey;
+    if (pCmd->Timestamp != Timestamp)
+        return;
 
-    if (!bIsLocked)
-    {
-        unsigned int i;
-        for (i = 0; i < (pCmd->Size / 8); i++)
-        {
-            const uint16_t Offset = pCmd->Offset + (i * 8U);
+    const uint8_t  Max    = (pCmd->Max < SCANLOG_BATCH) ? pCmd->Max : SCANLOG_BATCH;
+    const uint16_t Oldest = SCANLOG_First();
+    const uint16_t Next   = SCANLOG_Next();
+    uint16_t       First  = pCmd->First;
 
-            if (Offset >= 0x0F30 && Offset < 0x0F40)
-                if (!gIsLocked)
-                    bReloadEeprom = true;
+    // numbers wrap, what matters is how far back from Next they are
+    if ((uint16_t)(Next - First) > (uint16_t)(Next - Oldest))
+        First = Oldest;
 
-            if ((Offset < 0x0E98 || Offset >= 0x0EA0) || !bIsInLockScreen || pCmd->bAllowPassword)
-                EEPROM_WriteBuffer(Offset, &pCmd->Data[i * 8U]);
-        }
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Data.Tick_10ms = gGlobalSysTickCounter;
+    Reply.Data.First     = First;
+    Reply.Data.Next      = Next;
+    Reply.Data.BootFirst = SCANLOG_BootFirst();
 
-        if (bReloadEeprom)
-            SETTINGS_InitEEPROM();
-    }
+    while (Reply.Data.Count < Max && SCANLOG_Read(First + Reply.Data.Count, &Reply.Data.Entries[Reply.Data.Count]))
+        Reply.Data.Count++;
 
-    SendReply(&Reply, sizeof(Reply));
+    const uint16_t Size = sizeof(Reply) - (SCANLOG_BATCH - Reply.Data.Count) * sizeof(SCANLOG_Entry_t);
+
+    Reply.Header.ID   = 0x0552;
+    Reply.Header.Size = Size - sizeof(Reply.Header);
+
+    SendReply(&Reply, Size);
 }
+#endif
 
 // read RSSI
 static void CMD_0527(void)
@@ -337,9 +1360,10 @@ static void CMD_0529(void)
     SendReply(&Reply, sizeof(Reply));
 }
 
-static void CMD_052D(const uint8_t *pBuffer)
+static void CMD_052D(const CommandView_t *pView)
 {
-    const CMD_052D_t *pCmd = (const CMD_052D_t *)pBuffer;
+    CMD_052D_t        Cmd;
+    const CMD_052D_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
     REPLY_052D_t      Reply;
     bool              bIsLocked;
 
@@ -383,9 +1407,10 @@ static void CMD_052D(const uint8_t *pBuffer)
 // this command also disables dual watch, crossband, 
 // DTMF side tones, freq reverse, PTT ID, DTMF decoding, frequency offset
 // exits power save, sets main VFO to upper,
-static void CMD_052F(const uint8_t *pBuffer)
+static void CMD_052F(const CommandView_t *pView)
 {
-    const CMD_052F_t *pCmd = (const CMD_052F_t *)pBuffer;
+    CMD_052F_t        Cmd;
+    const CMD_052F_t *pCmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
 
     gEeprom.DUAL_WATCH                               = DUAL_WATCH_OFF;
     gEeprom.CROSS_BAND_RX_TX                         = CROSS_BAND_OFF;
@@ -404,6 +1429,8 @@ static void CMD_052F(const uint8_t *pBuffer)
 
     Timestamp = pCmd->Timestamp;
 
+    gTelemetryPeriod_10ms = 0;
+
     // turn the LCD backlight off
     BACKLIGHT_TurnOff();
 
@@ -411,14 +1438,15 @@ static void CMD_052F(const uint8_t *pBuffer)
 }
 
 #ifdef ENABLE_UART_RW_BK_REGS
-static void CMD_0601_ReadBK4819Reg(const uint8_t *pBuffer)
+static void CMD_0601_ReadBK4819Reg(const CommandView_t *pView)
 {
     typedef struct  __attribute__((__packed__)) {
         Header_t header;
         uint8_t reg;
     } CMD_0601_t;
 
-    CMD_0601_t *cmd = (CMD_0601_t*) pBuffer;
+    CMD_0601_t Cmd;
+    const CMD_0601_t *cmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
 
     struct __attribute__((__packed__)) {
         Header_t header;
@@ -435,7 +1463,7 @@ static void CMD_0601_ReadBK4819Reg(const uint8_t *pBuffer)
     SendReply(&reply, sizeof(reply));
 }
 
-static void CMD_0602_WriteBK4819Reg(const uint8_t *pBuffer)
+static void CMD_0602_WriteBK4819Reg(const CommandView_t *pView)
 {
     typedef struct __attribute__((__packed__)) {
         Header_t header;
@@ -443,118 +1471,116 @@ static void CMD_0602_WriteBK4819Reg(const uint8_t *pBuffer)
         uint16_t value;
     } CMD_0602_t;
 
-    CMD_0602_t *cmd = (CMD_0602_t*) pBuffer;
+    CMD_0602_t Cmd;
+    const CMD_0602_t *cmd = View_Fetch(pView, &Cmd, sizeof(Cmd));
     BK4819_WriteRegister(cmd->reg, cmd->value);
 }
 #endif
 
+// Incremental frame parser working on the DMA ring in place. Each call
+// only looks at what arrived since the last one: the hunt for a header
+// resumes where it stopped, and a frame whose header has been seen just
+// waits for the rest of its bytes. A complete frame is checked in the
+// ring (footer and CRC) and left there for UART_HandleCommand(), which
+// reads it through gCommand and then consumes it.
 bool UART_IsCommandAvailable(void)
 {
-    uint16_t Index;
-    uint16_t TailIndex;
-    uint16_t Size;
-    uint16_t CRC;
-    uint16_t CommandLength;
-    uint16_t DmaLength = DMA_CH0->ST & 0xFFFU;
+    const uint16_t DmaIndex = UART_RxIndex();
 
     while (1)
     {
-        if (gUART_WriteIndex == DmaLength)
-            return false;
-
-        while (gUART_WriteIndex != DmaLength && UART_DMA_Buffer[gUART_WriteIndex] != 0xABU)
-            gUART_WriteIndex = DMA_INDEX(gUART_WriteIndex, 1);
-
-        if (gUART_WriteIndex == DmaLength)
-            return false;
-
-        if (gUART_WriteIndex < DmaLength)
-            CommandLength = DmaLength - gUART_WriteIndex;
-        else
-            CommandLength = (DmaLength + sizeof(UART_DMA_Buffer)) - gUART_WriteIndex;
+        const uint16_t Available = DMA_INDEX(DmaIndex + UART_RX_RING_SIZE - gFrameIndex, 0);
+        uint16_t       Size;
+        uint16_t       Index;
+        uint16_t       CRC;
+        uint8_t        Buffer[16];
 
-        if (CommandLength < 8)
-            return 0;
+        if (!gFrameFound)
+        {
+            uint16_t Left = Available;
 
-        if (UART_DMA_Buffer[DMA_INDEX(gUART_WriteIndex, 1)] == 0xCD)
-            break;
+            while (Left >= 2 && (UART_DMA_Buffer[gFrameIndex] != 0xAB || UART_DMA_Buffer[DMA_INDEX(gFrameIndex, 1)] != 0xCD))
+            {
+                gFrameIndex = DMA_INDEX(gFrameIndex, 1);
+                Left--;
+            }
 
-        gUART_WriteIndex = DMA_INDEX(gUART_WriteIndex, 1);
-    }
+            if (Left < 2)
+                return false;
 
-    Index = DMA_INDEX(gUART_WriteIndex, 2);
-    Size  = (UART_DMA_Buffer[DMA_INDEX(Index, 1)] << 8) | UART_DMA_Buffer[Index];
+            gFrameFound = true;
+            continue;
+        }
 
-    if ((Size + 8u) > sizeof(UART_DMA_Buffer))
-    {
-        gUART_WriteIndex = DmaLength;
-        return false;
-    }
+        if (Available < 4)
+            return false;
 
-    if (CommandLength < (Size + 8))
-        return false;
+        Size = UART_DMA_Buffer[DMA_INDEX(gFrameIndex, 2)] | (UART_DMA_Buffer[DMA_INDEX(gFrameIndex, 3)] << 8);
 
-    Index     = DMA_INDEX(Index, 2);
-    TailIndex = DMA_INDEX(Index, Size + 2);
+        if (Size < sizeof(Header_t) || (Size + 8u) > FRAME_MAX)
+        {   // not a header after all, hunt on from the next byte
+            gFrameIndex = DMA_INDEX(gFrameIndex, 1);
+            gFrameFound = false;
+            continue;
+        }
 
-    if (UART_DMA_Buffer[TailIndex] != 0xDC || UART_DMA_Buffer[DMA_INDEX(TailIndex, 1)] != 0xBA)
-    {
-        gUART_WriteIndex = DmaLength;
-        return false;
-    }
+        if (Available < Size + 8u)
+            return false;
 
-    if (TailIndex < Index)
-    {
-        const uint16_t ChunkSize = sizeof(UART_DMA_Buffer) - Index;
-        memcpy(UART_Command.Buffer, UART_DMA_Buffer + Index, ChunkSize);
-        memcpy(UART_Command.Buffer + ChunkSize, UART_DMA_Buffer, TailIndex);
-    }
-    else
-        memcpy(UART_Command.Buffer, UART_DMA_Buffer + Index, TailIndex - Index);
+        Index = DMA_INDEX(gFrameIndex, Size + 6);
+        if (UART_DMA_Buffer[Index] != 0xDC || UART_DMA_Buffer[DMA_INDEX(Index, 1)] != 0xBA)
+        {
+            gFrameIndex = DMA_INDEX(gFrameIndex, 1);
+            gFrameFound = false;
+            continue;
+        }
 
-    TailIndex = DMA_INDEX(TailIndex, 2);
-    if (TailIndex < gUART_WriteIndex)
-    {
-        memset(UART_DMA_Buffer + gUART_WriteIndex, 0, sizeof(UART_DMA_Buffer) - gUART_WriteIndex);
-        memset(UART_DMA_Buffer, 0, TailIndex);
-    }
-    else
-        memset(UART_DMA_Buffer + gUART_WriteIndex, 0, TailIndex - gUART_WriteIndex);
+        gCommand.Start = DMA_INDEX(gFrameIndex, 4);
+        gCommand.Size  = Size;
 
-    gUART_WriteIndex = TailIndex;
+        // a plain session init turns the obfuscation off, 0x6902 back on
+        Index = UART_DMA_Buffer[gCommand.Start] | (UART_DMA_Buffer[DMA_INDEX(gCommand.Start, 1)] << 8);
+        if (Index == 0x0514)
+            bIsEncrypted = false;
+        if (Index == 0x6902)
+            bIsEncrypted = true;
 
-    if (UART_Command.Header.ID == 0x0514)
-        bIsEncrypted = false;
+        CRC_Begin();
+        for (uint16_t Offset = 0; Offset < Size; Offset += sizeof(Buffer))
+        {
+            const uint16_t Left = Size - Offset;
+            const uint16_t n    = (Left < sizeof(Buffer)) ? Left : sizeof(Buffer);
+            RingRead(gCommand.Start, Offset, Buffer, n);
+            CRC_Update(Buffer, n);
+        }
+        RingRead(gCommand.Start, Size, &CRC, sizeof(CRC));
 
-    if (UART_Command.Header.ID == 0x6902)
-        bIsEncrypted = true;
+        if (CRC_End() == CRC)
+            return true;
 
-    if (bIsEncrypted)
-    {
-        unsigned int i;
-        for (i = 0; i < (Size + 2u); i++)
-            UART_Command.Buffer[i] ^= Obfuscation[i % 16];
+        // corrupted, drop the whole frame
+        gFrameIndex = DMA_INDEX(gFrameIndex, Size + 8);
+        gFrameFound = false;
     }
-    
-    CRC = UART_Command.Buffer[Size] | (UART_Command.Buffer[Size + 1] << 8);
-
-    return (CRC_Calculate(UART_Command.Buffer, Size) != CRC) ? false : true;
 }
 
 void UART_HandleCommand(void)
 {
-    switch (UART_Command.Header.ID)
+    // the host made it through at the current rate
+    gBaudConfirmCountdown_500ms = 0;
+
+    switch (View_ID(&gCommand))
     {
         case 0x0514:
-            CMD_0514(UART_Command.Buffer);
+            CMD_0514(&gCommand);
             break;
     
         case 0x051B:
-            CMD_051B(UART_Command.Buffer);
+            CMD_051B(&gCommand);
             break;
     
         case 0x051D:
-            CMD_051D(UART_Command.Buffer);
+            CMD_051D(&gCommand);
             break;
     
         case 0x051F:    // Not implementing non-authentic command
@@ -572,25 +1598,132 @@ void UART_HandleCommand(void)
             break;
     
         case 0x052D:
-            CMD_052D(UART_Command.Buffer);
+            CMD_052D(&gCommand);
             break;
     
         case 0x052F:
-            CMD_052F(UART_Command.Buffer);
+            CMD_052F(&gCommand);
+            break;
+
+        case 0x0535:
+            CMD_0535(&gCommand);
+            break;
+
+        case 0x0537:
+            CMD_0537(&gCommand);
+            break;
+
+        case 0x0539:
+            CMD_0539(&gCommand);
+            break;
+
+        case 0x053B:
+            CMD_053B(&gCommand);
+            break;
+
+        case 0x053D:
+            CMD_053D(&gCommand);
+            break;
+
+        case 0x053F:
+            CMD_053F(&gCommand);
+            break;
+
+        case 0x0543:
+            CMD_0543(&gCommand);
             break;
+
+        case 0x0545:
+            CMD_0545(&gCommand);
+            break;
+
+#if defined(ENABLE_SPECTRUM) && defined(ENABLE_UART)
+        case 0x0549:
+            CMD_0549(&gCommand);
+            break;
+
+        case 0x054B:
+            CMD_054B(&gCommand);
+            break;
+
+        case 0x054D:
+            CMD_054D(&gCommand);
+            break;
+
+        case 0x054F:
+            CMD_054F(&gCommand);
+            break;
+#endif
+
+#ifdef ENABLE_SCAN_LOG
+        case 0x0551:
+            CMD_0551(&gCommand);
+            break;
+#endif
     
         case 0x05DD: // reset
+            SETTINGS_CommitSettings();
+            EEPROM_Flush();
             NVIC_SystemReset();
             break;
             
 #ifdef ENABLE_UART_RW_BK_REGS
         case 0x0601:
-            CMD_0601_ReadBK4819Reg(UART_Command.Buffer);
+            CMD_0601_ReadBK4819Reg(&gCommand);
             break;
         
         case 0x0602:
-            CMD_0602_WriteBK4819Reg(UART_Command.Buffer);
+            CMD_0602_WriteBK4819Reg(&gCommand);
             break;
 #endif
     }
+
+    // done with it, its bytes in the ring may be reused
+    gFrameIndex = DMA_INDEX(gCommand.Start, gCommand.Size + 4);
+    gFrameFound = false;
+}
+
+void UART_TimeSlice10ms(void)
+{
+    if (gKeyHold_10ms > 0) {
+        if (--gKeyHold_10ms == 0)
+            gKeyRelease_10ms = KEY_RELEASE_10ms;
+    }
+    else if (gKeyRelease_10ms > 0)
+        gKeyRelease_10ms--;
+
+#ifdef ENABLE_TRACE
+    // trace records wait for a quiet link, and for a programming
+    // session to be over
+    if (UART_IsSendComplete() && !SerialConfigInProgress())
+        SendTrace();
+#endif
+
+    if (gTelemetryPeriod_10ms == 0 || --gTelemetryCountdown_10ms > 0)
+        return;
+
+    gTelemetryCountdown_10ms = gTelemetryPeriod_10ms;
+    SendTelemetry();
+}
+
+// Let a telemetry subscription lapse when the host stopped renewing it.
+// Fall back to the default rate when a new one was never confirmed, or
+// when the session is over without the host restoring it.
+void UART_TimeSlice500ms(void)
+{
+    if (gTelemetryLease_500ms > 0 && --gTelemetryLease_500ms == 0)
+        gTelemetryPeriod_10ms = 0;
+
+    if (gBaudRate == UART_BAUD_RATE_DEFAULT)
+        return;
+
+    if (gBaudConfirmCountdown_500ms > 0) {
+        if (--gBaudConfirmCountdown_500ms > 0)
+            return;
+    }
+    else if (SerialConfigInProgress() || gTelemetryPeriod_10ms > 0)
+        return;
+
+    UART_SetBaudRate(UART_BAUD_RATE_DEFAULT);
+    gBaudRate = UART_BAUD_RATE_DEFAULT;
 }
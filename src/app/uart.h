@@ -19,8 +19,14 @@
 
 #include <stdbool.h>
 
+#include "driver/keyboard.h"
+
 bool UART_IsCommandAvailable(void);
 void UART_HandleCommand(void);
+void UART_TimeSlice10ms(void);
+void UART_TimeSlice500ms(void);
+KEY_Code_t UART_InjectedKey(void);
+bool       UART_IsKeyInjected(void);
 
 #endif
 
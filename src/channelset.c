@@ -0,0 +1,82 @@
+#include <string.h>
+
+#include "channelset.h"
+
+void CHANNELSET_Clear(ChannelSet_t *pSet)
+{
+    memset(pSet, 0, sizeof(*pSet));
+}
+
+void CHANNELSET_Union(ChannelSet_t *pDst, const ChannelSet_t *pSrc)
+{
+    for (unsigned int i = 0; i < CHANNELSET_WORDS; i++)
+        pDst->words[i] |= pSrc->words[i];
+}
+
+void CHANNELSET_Intersect(ChannelSet_t *pDst, const ChannelSet_t *pSrc)
+{
+    for (unsigned int i = 0; i < CHANNELSET_WORDS; i++)
+        pDst->words[i] &= pSrc->words[i];
+}
+
+void CHANNELSET_Subtract(ChannelSet_t *pDst, const ChannelSet_t *pSrc)
+{
+    for (unsigned int i = 0; i < CHANNELSET_WORDS; i++)
+        pDst->words[i] &= ~pSrc->words[i];
+}
+
+unsigned CHANNELSET_Count(const ChannelSet_t *pSet)
+{
+    unsigned count = 0;
+    for (unsigned int i = 0; i < CHANNELSET_WORDS; i++)
+        count += __builtin_popcount(pSet->words[i]);
+    return count;
+}
+
+// first member >= Channel, 0xFF if none
+static uint8_t FindUp(const ChannelSet_t *pSet, unsigned int Channel)
+{
+    for (unsigned int i = Channel / 32; i < CHANNELSET_WORDS; i++) {
+        uint32_t bits = pSet->words[i];
+        if (i == Channel / 32)
+            bits &= ~0u << (Channel % 32);
+        if (bits)
+            return i * 32 + __builtin_ctz(bits);
+    }
+    return 0xFF;
+}
+
+// last member <= Channel, 0xFF if none
+static uint8_t FindDown(const ChannelSet_t *pSet, unsigned int Channel)
+{
+    for (int i = Channel / 32; i >= 0; i--) {
+        uint32_t bits = pSet->words[i];
+        if ((unsigned int)i == Channel / 32)
+            bits &= ~0u >> (31 - Channel % 32);
+        if (bits)
+            return i * 32 + 31 - __builtin_clz(bits);
+    }
+    return 0xFF;
+}
+
+// returns the member that follows Channel in the given direction,
+// wrapping around the ends, or 0xFF if the set is empty
+uint8_t CHANNELSET_Next(const ChannelSet_t *pSet, uint8_t Channel, int8_t Direction)
+{
+    uint8_t next = 0xFF;
+
+    if (Direction > 0) {
+        if (Channel < MR_CHANNEL_LAST)
+            next = FindUp(pSet, Channel + 1);
+        if (next == 0xFF)
+            next = FindUp(pSet, MR_CHANNEL_FIRST);
+    }
+    else {
+        if (Channel > MR_CHANNEL_FIRST && IS_MR_CHANNEL(Channel))
+            next = FindDown(pSet, Channel - 1);
+        if (next == 0xFF)
+            next = FindDown(pSet, MR_CHANNEL_LAST);
+    }
+
+    return next;
+}
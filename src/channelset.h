@@ -0,0 +1,43 @@
+#ifndef CHANNELSET_H
+#define CHANNELSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "misc.h"
+
+// Bit-packed set of memory channels (one bit per MR channel).
+// Used for scan list membership and the scan exclude list, so that
+// combinations like "list 1 + list 3 - excluded" are a handful of
+// word operations.
+
+#define CHANNELSET_WORDS ((MR_CHANNEL_LAST + 1 + 31) / 32)
+
+typedef struct {
+    uint32_t words[CHANNELSET_WORDS];
+} ChannelSet_t;
+
+static inline bool CHANNELSET_Contains(const ChannelSet_t *pSet, uint8_t Channel)
+{
+    return IS_MR_CHANNEL(Channel) && (pSet->words[Channel / 32] >> (Channel % 32)) & 1u;
+}
+
+static inline void CHANNELSET_Assign(ChannelSet_t *pSet, uint8_t Channel, bool Member)
+{
+    if (!IS_MR_CHANNEL(Channel))
+        return;
+
+    if (Member)
+        pSet->words[Channel / 32] |=  (1u << (Channel % 32));
+    else
+        pSet->words[Channel / 32] &= ~(1u << (Channel % 32));
+}
+
+void     CHANNELSET_Clear(ChannelSet_t *pSet);
+void     CHANNELSET_Union(ChannelSet_t *pDst, const ChannelSet_t *pSrc);
+void     CHANNELSET_Intersect(ChannelSet_t *pDst, const ChannelSet_t *pSrc);
+void     CHANNELSET_Subtract(ChannelSet_t *pDst, const ChannelSet_t *pSrc);
+unsigned CHANNELSET_Count(const ChannelSet_t *pSet);
+uint8_t  CHANNELSET_Next(const ChannelSet_t *pSet, uint8_t Channel, int8_t Direction);
+
+#endif
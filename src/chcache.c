@@ -0,0 +1,342 @@
+#include <string.h>
+
+#include "chcache.h"
+#include "driver/eeprom.h"
+#include "misc.h"
+#include "scanlist.h"
+
+#define CHANNEL_RECORD_BASE 0x0000
+#define CHANNEL_NAME_BASE   0x0F50
+#define CHANNEL_NAME_SIZE   10
+
+// channels decoded per piece of the boot time EEPROM stream
+#define CHCACHE_CHUNK       8
+
+// a decoded record in 12 bytes instead of 13 + padding: frequencies and
+// offsets are below 2^27 (10 Hz units, offsets are clamped to 1 GHz)
+#define FREQUENCY_UNSET     0x7FFFFFF
+
+typedef struct {
+    uint32_t Frequency  : 27,   // FREQUENCY_UNSET if never set
+             Step       : 5;
+    uint32_t Offset     : 27,
+             Modulation : 3,
+             OffsetDir  : 2;
+    uint8_t  RxCode;
+    uint8_t  TxCode;
+    uint8_t  RxCodeType : 2,
+             TxCodeType : 2,
+             Reverse    : 1,
+             Bandwidth  : 1,
+             BusyLock   : 1,
+             TxLock     : 1;
+    uint8_t  Power      : 3,
+             PttId      : 3;
+} CachedRecord_t;
+
+_Static_assert(sizeof(CachedRecord_t) == 12, "cached channel record size");
+
+// names are 7 bit ASCII, packed 10 chars to 9 bytes, 0 ends a short one
+#define NAME_PACKED_SIZE    ((CHANNEL_NAME_SIZE * 7 + 7) / 8)
+
+// 2400 + 1800 bytes for a bank of 200 channels
+static CachedRecord_t  gRecords[MR_CHANNEL_LAST + 1];
+static uint8_t         gNames[MR_CHANNEL_LAST + 1][NAME_PACKED_SIZE];
+
+static uint32_t CachedFrequency(uint8_t Channel)
+{
+    const uint32_t f = gRecords[Channel].Frequency;
+    return (f == FREQUENCY_UNSET) ? 0xFFFFFFFF : f;
+}
+
+// channel numbers ordered by frequency (equal frequencies by channel number)
+static uint8_t         gByFrequency[MR_CHANNEL_LAST + 1];
+static uint8_t         gIndexCount;
+
+// first index position whose frequency is >= Frequency (or > if After)
+static uint8_t IndexSearch(uint32_t Frequency, bool After)
+{
+    uint8_t lo = 0;
+    uint8_t hi = gIndexCount;
+
+    while (lo < hi) {
+        const uint8_t  mid = (lo + hi) / 2;
+        const uint32_t f   = CachedFrequency(gByFrequency[mid]);
+        if (f < Frequency || (After && f == Frequency))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static void IndexRemove(uint8_t Channel)
+{
+    for (uint8_t i = 0; i < gIndexCount; i++) {
+        if (gByFrequency[i] == Channel) {
+            memmove(&gByFrequency[i], &gByFrequency[i + 1], gIndexCount - i - 1);
+            gIndexCount--;
+            return;
+        }
+    }
+}
+
+static void IndexInsert(uint8_t Channel)
+{
+    const uint8_t pos = IndexSearch(CachedFrequency(Channel), true);
+    memmove(&gByFrequency[pos + 1], &gByFrequency[pos], gIndexCount - pos);
+    gByFrequency[pos] = Channel;
+    gIndexCount++;
+}
+
+static bool IndexBefore(uint8_t A, uint8_t B)
+{
+    return CachedFrequency(A) < CachedFrequency(B) || (CachedFrequency(A) == CachedFrequency(B) && A < B);
+}
+
+// Sort the whole index at once. Linear when only a few frequencies
+// changed since the last sort, as after a reload of some channels.
+static void IndexSort(void)
+{
+    for (uint8_t i = 1; i < gIndexCount; i++) {
+        const uint8_t channel = gByFrequency[i];
+        uint8_t       j       = i;
+
+        for (; j > 0 && IndexBefore(channel, gByFrequency[j - 1]); j--)
+            gByFrequency[j] = gByFrequency[j - 1];
+        gByFrequency[j] = channel;
+    }
+}
+
+static bool IndexUsable(uint8_t Pos)
+{
+    const uint8_t channel = gByFrequency[Pos];
+    return CachedFrequency(channel) != 0xFFFFFFFF &&
+           CHANNELSET_Contains(&gMR_ChannelValid, channel);
+}
+
+static void PackName(uint8_t *pPacked, const char *s)
+{
+    memset(pPacked, 0, NAME_PACKED_SIZE);
+
+    for (unsigned int i = 0, bit = 0; i < CHANNEL_NAME_SIZE && s[i]; i++, bit += 7) {
+        const uint16_t v = (uint8_t)s[i] << (bit % 8);
+        pPacked[bit / 8] |= v;
+        if (v >> 8)
+            pPacked[bit / 8 + 1] |= v >> 8;
+    }
+}
+
+static void DecodeRecord(uint8_t Channel, const uint8_t *pData)
+{
+    ChannelRecord_t record;
+    CachedRecord_t *pCached = &gRecords[Channel];
+
+    SETTINGS_DecodeChannelRecord(pData, &record);
+
+    pCached->Frequency  = (record.Frequency < FREQUENCY_UNSET) ? record.Frequency : FREQUENCY_UNSET;
+    pCached->Step       = record.Step;
+    pCached->Offset     = record.Offset;
+    pCached->Modulation = record.Modulation;
+    pCached->OffsetDir  = record.OffsetDir;
+    pCached->RxCode     = record.RxCode;
+    pCached->TxCode     = record.TxCode;
+    pCached->RxCodeType = record.RxCodeType;
+    pCached->TxCodeType = record.TxCodeType;
+    pCached->Reverse    = record.Reverse;
+    pCached->Bandwidth  = record.Bandwidth;
+    pCached->BusyLock   = record.BusyLock;
+    pCached->TxLock     = record.TxLock;
+    pCached->Power      = record.Power;
+    pCached->PttId      = record.PttId;
+}
+
+static void DecodeName(uint8_t Channel, const uint8_t *pData)
+{
+    char name[CHANNEL_NAME_SIZE + 1];
+
+    SETTINGS_DecodeChannelName(name, pData);
+    PackName(gNames[Channel], name);
+}
+
+// the caller sorts the index afterwards
+static void LoadRecords(uint8_t First, uint8_t Count)
+{
+    uint8_t buf[CHCACHE_CHUNK * 16];
+
+    EEPROM_StreamBegin(SETTINGS_ChannelBankBase() + CHANNEL_RECORD_BASE + First * 16, Count * 16);
+
+    while (Count > 0) {
+        const uint8_t n = (Count < CHCACHE_CHUNK) ? Count : CHCACHE_CHUNK;
+
+        EEPROM_StreamRead(buf, n * 16);
+        for (uint8_t i = 0; i < n; i++)
+            DecodeRecord(First + i, buf + i * 16);
+
+        First += n;
+        Count -= n;
+    }
+}
+
+static void LoadNames(uint8_t First, uint8_t Count)
+{
+    uint8_t buf[CHCACHE_CHUNK * 16];
+
+    EEPROM_StreamBegin(SETTINGS_ChannelBankBase() + CHANNEL_NAME_BASE + First * 16, Count * 16);
+
+    while (Count > 0) {
+        const uint8_t n = (Count < CHCACHE_CHUNK) ? Count : CHCACHE_CHUNK;
+
+        EEPROM_StreamRead(buf, n * 16);
+        for (uint8_t i = 0; i < n; i++)
+            DecodeName(First + i, buf + i * 16);
+
+        First += n;
+        Count -= n;
+    }
+}
+
+void CHCACHE_Init(void)
+{
+    for (uint8_t i = 0; i <= MR_CHANNEL_LAST; i++)
+        gByFrequency[i] = i;
+    gIndexCount = MR_CHANNEL_LAST + 1;
+
+    LoadRecords(MR_CHANNEL_FIRST, MR_CHANNEL_LAST + 1);
+    LoadNames(MR_CHANNEL_FIRST, MR_CHANNEL_LAST + 1);
+    IndexSort();
+}
+
+uint32_t CHCACHE_GetFrequency(uint8_t Channel)
+{
+    if (!IS_MR_CHANNEL(Channel))
+        Channel = MR_CHANNEL_FIRST;
+    return CachedFrequency(Channel);
+}
+
+void CHCACHE_GetRecord(uint8_t Channel, ChannelRecord_t *pRecord)
+{
+    if (!IS_MR_CHANNEL(Channel))
+        Channel = MR_CHANNEL_FIRST;
+
+    const CachedRecord_t *pCached = &gRecords[Channel];
+
+    pRecord->Frequency  = CachedFrequency(Channel);
+    pRecord->Offset     = pCached->Offset;
+    pRecord->RxCode     = pCached->RxCode;
+    pRecord->TxCode     = pCached->TxCode;
+    pRecord->RxCodeType = pCached->RxCodeType;
+    pRecord->TxCodeType = pCached->TxCodeType;
+    pRecord->OffsetDir  = pCached->OffsetDir;
+    pRecord->Reverse    = pCached->Reverse;
+    pRecord->Bandwidth  = pCached->Bandwidth;
+    pRecord->Modulation = pCached->Modulation;
+    pRecord->Power      = pCached->Power;
+    pRecord->BusyLock   = pCached->BusyLock;
+    pRecord->TxLock     = pCached->TxLock;
+    pRecord->Step       = pCached->Step;
+    pRecord->PttId      = pCached->PttId;
+}
+
+// s must have room for 11 chars
+void CHCACHE_FetchName(char *s, uint8_t Channel)
+{
+    unsigned int i = 0;
+
+    if (IS_MR_CHANNEL(Channel)) {
+        const uint8_t *pPacked = gNames[Channel];
+
+        for (unsigned int bit = 0; i < CHANNEL_NAME_SIZE; i++, bit += 7) {
+            const uint16_t v = pPacked[bit / 8] | (pPacked[bit / 8 + 1] << 8);
+            s[i] = (v >> (bit % 8)) & 0x7F;
+            if (!s[i])
+                break;
+        }
+    }
+
+    s[i] = 0;
+}
+
+void CHCACHE_UpdateRecord(uint8_t Channel, const uint8_t *pData)
+{
+    if (!IS_MR_CHANNEL(Channel))
+        return;
+
+    IndexRemove(Channel);
+    DecodeRecord(Channel, pData);
+    IndexInsert(Channel);
+}
+
+void CHCACHE_UpdateName(uint8_t Channel, const uint8_t *pData)
+{
+    if (IS_MR_CHANNEL(Channel))
+        DecodeName(Channel, pData);
+}
+
+// reload every cached channel overlapping an EEPROM range written
+// behind our back (e.g. by the programming software)
+void CHCACHE_InvalidateRange(uint16_t Address, uint16_t Size)
+{
+    const uint16_t base = SETTINGS_ChannelBankBase();
+
+    // only the selected bank is cached
+    if (Size == 0 || Address < base || Address >= base + CHANNEL_BANK_SIZE)
+        return;
+
+    Address -= base;
+
+    const uint32_t end = (uint32_t)Address + Size;
+
+    if (Address < CHANNEL_RECORD_BASE + (MR_CHANNEL_LAST + 1) * 16) {
+        const uint8_t  first = (Address - CHANNEL_RECORD_BASE) / 16;
+        uint32_t       last  = (end - 1 - CHANNEL_RECORD_BASE) / 16;
+        if (last > MR_CHANNEL_LAST)
+            last = MR_CHANNEL_LAST;
+        LoadRecords(first, last - first + 1);
+        IndexSort();
+    }
+
+    if (end > CHANNEL_NAME_BASE && Address < CHANNEL_NAME_BASE + (MR_CHANNEL_LAST + 1) * 16) {
+        const uint8_t  first = (Address < CHANNEL_NAME_BASE) ? 0 : (Address - CHANNEL_NAME_BASE) / 16;
+        uint32_t       last  = (end - 1 - CHANNEL_NAME_BASE) / 16;
+        if (last > MR_CHANNEL_LAST)
+            last = MR_CHANNEL_LAST;
+        LoadNames(first, last - first + 1);
+    }
+}
+
+// lowest numbered valid memory channel on exactly Frequency, 0xFF if none
+uint8_t CHCACHE_FindChannel(uint32_t Frequency)
+{
+    for (uint8_t pos = IndexSearch(Frequency, false); pos < gIndexCount; pos++) {
+        if (CachedFrequency(gByFrequency[pos]) != Frequency)
+            break;
+        if (IndexUsable(pos))
+            return gByFrequency[pos];
+    }
+
+    return 0xFF;
+}
+
+// valid memory channel closest in frequency to Frequency, 0xFF if none
+uint8_t CHCACHE_FindNearestChannel(uint32_t Frequency)
+{
+    const uint8_t pos  = IndexSearch(Frequency, false);
+    int           up   = pos;
+    int           down = (int)pos - 1;
+
+    while (up < gIndexCount && !IndexUsable(up))
+        up++;
+    while (down >= 0 && !IndexUsable(down))
+        down--;
+
+    if (up >= gIndexCount)
+        return (down >= 0) ? gByFrequency[down] : 0xFF;
+    if (down < 0)
+        return gByFrequency[up];
+
+    const uint32_t above = CachedFrequency(gByFrequency[up]) - Frequency;
+    const uint32_t below = Frequency - CachedFrequency(gByFrequency[down]);
+    return gByFrequency[(below < above) ? down : up];
+}
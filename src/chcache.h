@@ -0,0 +1,27 @@
+#ifndef CHCACHE_H
+#define CHCACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "settings.h"
+
+// RAM copy of the decoded memory channel records and names, so that
+// tuning, scanning and the UI never touch the EEPROM for a memory
+// channel. Records are packed to 12 bytes and names to 9, 4.2 KB for a
+// bank. Filled at boot, refilled when another channel bank is selected
+// (the cache holds one bank at a time) and kept up to date by the
+// SETTINGS_ save functions (write-through). A frequency-ordered index
+// over the records turns frequency -> channel lookups into a binary search.
+
+void                   CHCACHE_Init(void);
+uint32_t               CHCACHE_GetFrequency(uint8_t Channel);
+void                   CHCACHE_GetRecord(uint8_t Channel, ChannelRecord_t *pRecord);
+void                   CHCACHE_FetchName(char *s, uint8_t Channel);
+void                   CHCACHE_UpdateRecord(uint8_t Channel, const uint8_t *pData);
+void                   CHCACHE_UpdateName(uint8_t Channel, const uint8_t *pData);
+void                   CHCACHE_InvalidateRange(uint16_t Address, uint16_t Size);
+uint8_t                CHCACHE_FindChannel(uint32_t Frequency);
+uint8_t                CHCACHE_FindNearestChannel(uint32_t Frequency);
+
+#endif
@@ -14,8 +14,6 @@
  *     limitations under the License.
  */
 
-#ifdef ENABLE_UART
-
 #include "../bsp/dp32g030/crc.h"
 #include "crc.h"
 
@@ -33,21 +31,35 @@ void CRC_Init(void)
     CRC_IV = 0;
 }
 
-uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size)
+// CRC over data arriving in pieces: CRC_Begin(), any number of
+// CRC_Update() and CRC_End() for the result
+void CRC_Begin(void)
 {
-    const uint8_t *pData = (const uint8_t *)pBuffer;
-    uint16_t i, Crc;
-
     CRC_CR = (CRC_CR & ~CRC_CR_CRC_EN_MASK) | CRC_CR_CRC_EN_BITS_ENABLE;
+}
+
+void CRC_Update(const void *pBuffer, uint16_t Size)
+{
+    const uint8_t *pData = (const uint8_t *)pBuffer;
+    uint16_t i;
 
     for (i = 0; i < Size; i++) {
         CRC_DATAIN = pData[i];
     }
-    Crc = (uint16_t)CRC_DATAOUT;
+}
+
+uint16_t CRC_End(void)
+{
+    const uint16_t Crc = (uint16_t)CRC_DATAOUT;
 
     CRC_CR = (CRC_CR & ~CRC_CR_CRC_EN_MASK) | CRC_CR_CRC_EN_BITS_DISABLE;
 
     return Crc;
 }
 
-#endif
\ No newline at end of file
+uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size)
+{
+    CRC_Begin();
+    CRC_Update(pBuffer, Size);
+    return CRC_End();
+}
@@ -17,14 +17,13 @@
 #ifndef DRIVER_CRC_H
 #define DRIVER_CRC_H
 
-#ifdef ENABLE_UART
-
 #include <stdint.h>
 
 void CRC_Init(void);
+void CRC_Begin(void);
+void CRC_Update(const void *pBuffer, uint16_t Size);
+uint16_t CRC_End(void);
 uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size);
 
 #endif
 
-#endif
-
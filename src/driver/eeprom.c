@@ -14,15 +14,94 @@
  *     limitations under the License.
  */
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
 #include "driver/eeprom.h"
 #include "driver/i2c.h"
-#include "driver/system.h"
+#include "driver/systick.h"
 
-void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
+// Write-back page buffer: EEPROM_WriteBuffer() only updates a RAM copy of
+// the affected EEPROM page, EEPROM_Flush() burns every modified page with
+// a single page write. Reads are served through the buffer so callers
+// always see their own writes.
+
+typedef struct {
+    uint16_t Address;   // page start, EEPROM_PAGE_FREE if unused
+    uint16_t Stamp;     // last use, for picking the page to evict
+    bool     Dirty;
+    uint8_t  Data[EEPROM_PAGE_SIZE];
+} EEPROM_Page_t;
+
+#define EEPROM_PAGE_FREE 0xFFFF
+
+static EEPROM_Page_t gPages[EEPROM_CACHE_PAGES] = {
+    [0 ... EEPROM_CACHE_PAGES - 1] = { .Address = EEPROM_PAGE_FREE }
+};
+static uint16_t gPageStamp;
+
+// a page write was started and the chip may still be burning it
+static bool     gBurning;
+
+uint32_t gEepromSize = EEPROM_SIZE_MIN;
+
+// while burning the chip does not acknowledge its address
+static bool ProbeReady(void)
+{
+    I2C_Start();
+    const bool ready = I2C_Write(0xA0) == 0;
+    I2C_Stop();
+
+    if (ready)
+        gBurning = false;
+
+    return ready;
+}
+
+static void WaitReady(void)
+{
+    // datasheet worst case is 5 ms, give up after 10 ms
+    for (unsigned int i = 0; gBurning && i < 100; i++) {
+        if (ProbeReady())
+            return;
+        SYSTICK_DelayUs(100);
+    }
+
+    gBurning = false;
+}
+
+// copy the buffered pages over data just read from the chip
+static void Overlay(uint16_t Address, void *pBuffer, uint16_t Size)
+{
+    for (unsigned int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+        const EEPROM_Page_t *pPage = &gPages[i];
+        if (pPage->Address == EEPROM_PAGE_FREE)
+            continue;
+
+        const uint16_t start = (pPage->Address > Address) ? pPage->Address : Address;
+        const uint32_t endPage = pPage->Address + EEPROM_PAGE_SIZE;
+        const uint32_t endRead = (uint32_t)Address + Size;
+        const uint32_t end = (endPage < endRead) ? endPage : endRead;
+
+        if (start < end)
+            memcpy((uint8_t *)pBuffer + (start - Address), pPage->Data + (start - pPage->Address), end - start);
+    }
+}
+
+static uint16_t gStreamAddress;
+static uint16_t gStreamLeft;
+
+// Sequential read of Size bytes in a single I2C transaction, fetched in
+// pieces with EEPROM_StreamRead(). No other EEPROM access may happen
+// until all Size bytes have been read.
+void EEPROM_StreamBegin(uint16_t Address, uint16_t Size)
 {
+    if (Size == 0)
+        return;
+
+    WaitReady();
+
     I2C_Start();
 
     I2C_Write(0xA0);
@@ -34,30 +113,212 @@ void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
 
     I2C_Write(0xA1);
 
-    I2C_ReadBuffer(pBuffer, Size);
+    gStreamAddress = Address;
+    gStreamLeft    = Size;
+}
 
-    I2C_Stop();
+void EEPROM_StreamRead(void *pBuffer, uint16_t Size)
+{
+    uint8_t *pData = pBuffer;
+
+    if (Size > gStreamLeft)
+        Size = gStreamLeft;
+
+    for (uint16_t i = 0; i < Size; i++)
+        pData[i] = I2C_ReadFast(--gStreamLeft == 0);
+
+    if (Size > 0 && gStreamLeft == 0)
+        I2C_Stop();
+
+    Overlay(gStreamAddress, pBuffer, Size);
+    gStreamAddress += Size;
 }
 
-void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer)
+void EEPROM_StreamSkip(uint16_t Size)
 {
-    if (pBuffer == NULL || Address >= 0x2000)
+    uint8_t buf[16];
+
+    // A new transaction costs two starts, a stop and four address bytes,
+    // about as long as clocking in six bytes: longer gaps are stepped over.
+    if (Size > 6 && Size < gStreamLeft) {
+        I2C_ReadFast(true);
+        I2C_Stop();
+        EEPROM_StreamBegin(gStreamAddress + Size, gStreamLeft - Size);
+        return;
+    }
+
+    while (Size > 0) {
+        const uint16_t n = (Size < sizeof(buf)) ? Size : sizeof(buf);
+        EEPROM_StreamRead(buf, n);
+        Size -= n;
+    }
+}
+
+void EEPROM_ReadLarge(uint16_t Address, void *pBuffer, uint16_t Size)
+{
+    if (Size == 0)
         return;
 
+    EEPROM_StreamBegin(Address, Size);
+    EEPROM_StreamRead(pBuffer, Size);
+}
 
-    uint8_t buffer[8];
-    EEPROM_ReadBuffer(Address, buffer, 8);
-    if (memcmp(pBuffer, buffer, 8) == 0) {
+static void FlushPage(EEPROM_Page_t *pPage)
+{
+    if (!pPage->Dirty)
         return;
+
+    WaitReady();
+
+    I2C_Start();
+    I2C_Write(0xA0);
+    I2C_Write((pPage->Address >> 8) & 0xFF);
+    I2C_Write((pPage->Address >> 0) & 0xFF);
+    I2C_WriteBuffer(pPage->Data, EEPROM_PAGE_SIZE);
+    I2C_Stop();
+
+    // the burn completes in the background, see WaitReady()
+    gBurning     = true;
+    pPage->Dirty = false;
+}
+
+static EEPROM_Page_t *GetPage(uint16_t Address)
+{
+    EEPROM_Page_t *pVictim = &gPages[0];
+
+    for (unsigned int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+        EEPROM_Page_t *pPage = &gPages[i];
+
+        if (pPage->Address == Address) {
+            pPage->Stamp = ++gPageStamp;
+            return pPage;
+        }
+
+        if (pVictim->Address == EEPROM_PAGE_FREE)
+            continue;
+        if (pPage->Address == EEPROM_PAGE_FREE || (int16_t)(pPage->Stamp - pVictim->Stamp) < 0)
+            pVictim = pPage;
     }
 
+    FlushPage(pVictim);
+
+    EEPROM_ReadLarge(Address, pVictim->Data, EEPROM_PAGE_SIZE);
+    pVictim->Address = Address;
+    pVictim->Stamp   = ++gPageStamp;
+    pVictim->Dirty   = false;
+
+    return pVictim;
+}
+
+// single byte write around the page buffer, for EEPROM_DetectSize()
+static void WriteByte(uint16_t Address, uint8_t Value)
+{
+    WaitReady();
+
     I2C_Start();
     I2C_Write(0xA0);
     I2C_Write((Address >> 8) & 0xFF);
     I2C_Write((Address >> 0) & 0xFF);
-    I2C_WriteBuffer(pBuffer, 8);
+    I2C_Write(Value);
     I2C_Stop();
 
-    // give the EEPROM time to burn the data in (apparently takes 5ms)
-    SYSTEM_DelayMs(8);
+    gBurning = true;
+}
+
+// The parts ignore the address bits above their size, so a part of N
+// bytes shows the same data at A and A + N. Look for the smallest size
+// at which the addressing wraps, comparing the settings seal page (it
+// holds a magic number) with its would-be alias. Must run before anything
+// is written through the page buffer.
+void EEPROM_DetectSize(void)
+{
+    const uint16_t probe = 0x1FA0;
+    uint8_t        low[16];
+    uint8_t        high[16];
+
+    for (gEepromSize = EEPROM_SIZE_MIN; gEepromSize < EEPROM_SIZE_MAX; gEepromSize *= 2) {
+        const uint16_t alias = probe + gEepromSize;
+
+        EEPROM_ReadLarge(probe, low, sizeof(low));
+        EEPROM_ReadLarge(alias, high, sizeof(high));
+        if (memcmp(low, high, sizeof(low)) != 0)
+            continue;
+
+        bool erased = true;
+        for (unsigned int i = 0; i < sizeof(low); i++)
+            erased &= (low[i] == 0xFF);
+        if (!erased)
+            break;
+
+        // both erased, nothing to tell them apart: mark the alias and
+        // see whether the mark shows up at the probe
+        WriteByte(alias, 0x00);
+        EEPROM_ReadLarge(probe, low, 1);
+        WriteByte(alias, 0xFF);
+        WaitReady();
+        if (low[0] == 0x00)
+            break;
+    }
+}
+
+void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
+{
+    EEPROM_ReadLarge(Address, pBuffer, Size);
+}
+
+void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer)
+{
+    if (pBuffer == NULL || Address >= gEepromSize)
+        return;
+
+    const uint8_t *pData = pBuffer;
+    unsigned int   Size  = 8;
+
+    while (Size > 0) {
+        const unsigned int offset = Address % EEPROM_PAGE_SIZE;
+        const unsigned int n      = (Size < EEPROM_PAGE_SIZE - offset) ? Size : EEPROM_PAGE_SIZE - offset;
+        EEPROM_Page_t     *pPage  = GetPage(Address - offset);
+
+        if (memcmp(pPage->Data + offset, pData, n) != 0) {
+            memcpy(pPage->Data + offset, pData, n);
+            pPage->Dirty = true;
+        }
+
+        Address += n;
+        pData   += n;
+        Size    -= n;
+    }
+}
+
+bool EEPROM_IsDirty(void)
+{
+    for (unsigned int i = 0; i < EEPROM_CACHE_PAGES; i++)
+        if (gPages[i].Dirty)
+            return true;
+    return false;
+}
+
+void EEPROM_Flush(void)
+{
+    for (unsigned int i = 0; i < EEPROM_CACHE_PAGES; i++)
+        FlushPage(&gPages[i]);
+
+    WaitReady();
+}
+
+// Non-blocking flush: starts burning at most one page and returns at once.
+// Returns true while there is still work left, call again later.
+bool EEPROM_FlushStep(void)
+{
+    if (gBurning && !ProbeReady())
+        return true;
+
+    for (unsigned int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+        if (gPages[i].Dirty) {
+            FlushPage(&gPages[i]);
+            return true;
+        }
+    }
+
+    return false;
 }
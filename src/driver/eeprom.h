@@ -17,10 +17,33 @@
 #ifndef DRIVER_EEPROM_H
 #define DRIVER_EEPROM_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+// 24C64: 32 byte write pages (the larger parts have 64 or 128 byte pages,
+// a 32 byte aligned write never crosses one of those either)
+#define EEPROM_PAGE_SIZE   32
+// pages held in RAM until EEPROM_Flush()
+#define EEPROM_CACHE_PAGES 8
+
+// 24C64 up to 24C512, all addressed with 16 bits
+#define EEPROM_SIZE_MIN    0x2000
+#define EEPROM_SIZE_MAX    0x10000
+
+// bytes the fitted part holds, see EEPROM_DetectSize()
+extern uint32_t gEepromSize;
+
+void EEPROM_DetectSize(void);
+
 void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size);
+void EEPROM_ReadLarge(uint16_t Address, void *pBuffer, uint16_t Size);
+void EEPROM_StreamBegin(uint16_t Address, uint16_t Size);
+void EEPROM_StreamRead(void *pBuffer, uint16_t Size);
+void EEPROM_StreamSkip(uint16_t Size);
 void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer);
+bool EEPROM_IsDirty(void);
+void EEPROM_Flush(void);
+bool EEPROM_FlushStep(void);
 
 #endif
 
@@ -132,6 +132,62 @@ int I2C_Write(uint8_t Data)
     return ret;
 }
 
+// Fast mode (400 kHz) variant of I2C_Read(), for parts rated for it (the
+// EEPROM). SYSTICK_DelayUs(1) costs well over a microsecond per call, the
+// delays are counted in SysTick (core clock) ticks instead, so they hold
+// whatever the clock and however the compiler schedules the loop.
+static uint32_t gFastDelayTicks;
+
+static inline void FastDelay(void)
+{
+    SYSTICK_DelayTicks(gFastDelayTicks);
+}
+
+uint8_t I2C_ReadFast(bool bFinal)
+{
+    uint8_t i, Data;
+
+    if (gFastDelayTicks == 0)
+        gFastDelayTicks = SYSTICK_NsToTicks(I2C_FAST_DELAY_NS);
+
+    PORTCON_PORTA_IE |= PORTCON_PORTA_IE_A11_BITS_ENABLE;
+    PORTCON_PORTA_OD &= ~PORTCON_PORTA_OD_A11_MASK;
+    GPIOA->DIR &= ~GPIO_DIR_11_MASK;
+
+    Data = 0;
+    for (i = 0; i < 8; i++) {
+        GPIO_ClearBit(&GPIOA->DATA, GPIOA_PIN_I2C_SCL);
+        FastDelay();
+        FastDelay();
+        GPIO_SetBit(&GPIOA->DATA, GPIOA_PIN_I2C_SCL);
+        FastDelay();
+        FastDelay();
+        Data <<= 1;
+        if (GPIO_CheckBit(&GPIOA->DATA, GPIOA_PIN_I2C_SDA)) {
+            Data |= 1U;
+        }
+    }
+
+    GPIO_ClearBit(&GPIOA->DATA, GPIOA_PIN_I2C_SCL);
+    PORTCON_PORTA_IE &= ~PORTCON_PORTA_IE_A11_MASK;
+    PORTCON_PORTA_OD |= PORTCON_PORTA_OD_A11_BITS_ENABLE;
+    GPIOA->DIR |= GPIO_DIR_11_BITS_OUTPUT;
+    if (bFinal) {
+        GPIO_SetBit(&GPIOA->DATA, GPIOA_PIN_I2C_SDA);
+    } else {
+        GPIO_ClearBit(&GPIOA->DATA, GPIOA_PIN_I2C_SDA);
+    }
+    FastDelay();
+    FastDelay();
+    GPIO_SetBit(&GPIOA->DATA, GPIOA_PIN_I2C_SCL);
+    FastDelay();
+    FastDelay();
+    GPIO_ClearBit(&GPIOA->DATA, GPIOA_PIN_I2C_SCL);
+    FastDelay();
+
+    return Data;
+}
+
 int I2C_ReadBuffer(void *pBuffer, uint8_t Size)
 {
     uint8_t *pData = (uint8_t *)pBuffer;
@@ -28,7 +28,12 @@ enum {
 void I2C_Start(void);
 void I2C_Stop(void);
 
+// I2C_ReadFast() keeps SCL low and high for two of these each: >= 1.3 us
+// low (the fast mode minimum) and a clock period >= 2.5 us (400 kHz)
+#define I2C_FAST_DELAY_NS 650
+
 uint8_t I2C_Read(bool bFinal);
+uint8_t I2C_ReadFast(bool bFinal);
 int I2C_Write(uint8_t Data);
 
 int I2C_ReadBuffer(void *pBuffer, uint8_t Size);
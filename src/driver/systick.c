@@ -27,6 +27,20 @@ void SYSTICK_Init(void)
     gTickMultiplier = 48;
 }
 
+// microseconds since boot (wraps after ~71 minutes)
+uint32_t SYSTICK_GetUs(void)
+{
+    uint32_t ticks;
+    uint32_t val;
+
+    do {    // retry if the 10 ms interrupt fired in between
+        ticks = gGlobalSysTickCounter;
+        val   = SysTick->VAL;
+    } while (ticks != gGlobalSysTickCounter);
+
+    return ticks * 10000u + (SysTick->LOAD - val) / gTickMultiplier;
+}
+
 void SYSTICK_DelayUs(uint32_t Delay)
 {
     const uint32_t ticks = Delay * gTickMultiplier;
@@ -47,3 +61,22 @@ void SYSTICK_DelayUs(uint32_t Delay)
         Previous = Current;
     } while (elapsed_ticks < ticks);
 }
+
+uint32_t SYSTICK_NsToTicks(uint32_t Delay)
+{
+    return (Delay * gTickMultiplier + 999) / 1000;
+}
+
+// Busy wait for Ticks core clocks (less than the 10 ms reload), for delays
+// too short for SYSTICK_DelayUs(). Never shorter, the loop only adds.
+void SYSTICK_DelayTicks(uint32_t Ticks)
+{
+    const uint32_t reload = SysTick->LOAD + 1;
+    const uint32_t start  = SysTick->VAL;
+    uint32_t       elapsed;
+
+    do {
+        const uint32_t now = SysTick->VAL;
+        elapsed = (now <= start) ? start - now : start + reload - now;
+    } while (elapsed < Ticks);
+}
@@ -21,6 +21,9 @@
 
 void SYSTICK_Init(void);
 void SYSTICK_DelayUs(uint32_t Delay);
+uint32_t SYSTICK_GetUs(void);
+uint32_t SYSTICK_NsToTicks(uint32_t Delay);
+void SYSTICK_DelayTicks(uint32_t Ticks);
 
 #endif
 
@@ -15,13 +15,33 @@
  */
 
 #include <stdbool.h>
+#include "ARMCM0.h"
 #include "bsp/dp32g030/dma.h"
+#include "bsp/dp32g030/irq.h"
 #include "bsp/dp32g030/syscon.h"
 #include "bsp/dp32g030/uart.h"
 #include "driver/uart.h"
 
 static bool UART_IsLogEnabled;
-uint8_t UART_DMA_Buffer[256];
+uint8_t UART_DMA_Buffer[UART_RX_RING_SIZE];
+
+// the DMA length field is 12 bits wide
+_Static_assert(UART_RX_RING_SIZE >= 256 && UART_RX_RING_SIZE <= 4096, "UART_RX_RING_SIZE out of range");
+
+static uint32_t gClockFrequency;
+
+// transmit ring, drained by DMA channel 1 one contiguous piece at a time
+static uint8_t           gTxRing[UART_TX_RING_SIZE];
+static volatile uint16_t gTxHead;   // where the next queued byte goes
+static volatile uint16_t gTxTail;   // next byte to leave
+static volatile uint16_t gTxChunk;  // bytes the DMA is moving, 0 when idle
+
+// the divisor has always been Frequency / 39053 for 38400 baud, keep
+// that trim for the other rates
+static uint32_t Divisor(uint32_t BaudRate)
+{
+    return gClockFrequency / (BaudRate + (BaudRate * 653U) / 38400U);
+}
 
 void UART_Init(void)
 {
@@ -39,8 +59,10 @@ void UART_Init(void)
         Frequency = 48000000U - Frequency;
     }
 
-    UART1->BAUD = Frequency / 39053U;
-    UART1->CTRL = UART_CTRL_RXEN_BITS_ENABLE | UART_CTRL_TXEN_BITS_ENABLE | UART_CTRL_RXDMAEN_BITS_ENABLE;
+    gClockFrequency = Frequency;
+
+    UART1->BAUD = Divisor(UART_BAUD_RATE_DEFAULT);
+    UART1->CTRL = UART_CTRL_RXEN_BITS_ENABLE | UART_CTRL_TXEN_BITS_ENABLE | UART_CTRL_RXDMAEN_BITS_ENABLE | UART_CTRL_TXDMAEN_BITS_ENABLE;
     UART1->RXTO = 4;
     UART1->FC = 0;
     UART1->FIFO = UART_FIFO_RF_LEVEL_BITS_8_BYTE | UART_FIFO_RF_CLR_BITS_ENABLE | UART_FIFO_TF_CLR_BITS_ENABLE;
@@ -60,7 +82,23 @@ void UART_Init(void)
         | DMA_CH_MOD_MD_SIZE_BITS_8BIT
         | DMA_CH_MOD_MD_SEL_BITS_SRAM
         ;
-    DMA_INTEN = 0;
+    DMA_CH1->CTR = 0;
+    DMA_CH1->MDADDR = (uint32_t)(uintptr_t)&UART1->TDR;
+    DMA_CH1->MOD = 0
+        // Source
+        | DMA_CH_MOD_MS_ADDMOD_BITS_INCREMENT
+        | DMA_CH_MOD_MS_SIZE_BITS_8BIT
+        | DMA_CH_MOD_MS_SEL_BITS_SRAM
+        // Destination
+        | DMA_CH_MOD_MD_ADDMOD_BITS_NONE
+        | DMA_CH_MOD_MD_SIZE_BITS_8BIT
+        | DMA_CH_MOD_MD_SEL_BITS_HSREQ_MS1
+        ;
+    gTxHead  = 0;
+    gTxTail  = 0;
+    gTxChunk = 0;
+
+    DMA_INTEN = DMA_INTEN_CH1_TC_INTEN_BITS_ENABLE;
     DMA_INTST = 0
         | DMA_INTST_CH0_TC_INTST_BITS_SET
         | DMA_INTST_CH1_TC_INTST_BITS_SET
@@ -73,7 +111,7 @@ void UART_Init(void)
         ;
     DMA_CH0->CTR = 0
         | DMA_CH_CTR_CH_EN_BITS_ENABLE
-        | ((0xFF << DMA_CH_CTR_LENGTH_SHIFT) & DMA_CH_CTR_LENGTH_MASK)
+        | (((UART_RX_RING_SIZE - 1) << DMA_CH_CTR_LENGTH_SHIFT) & DMA_CH_CTR_LENGTH_MASK)
         | DMA_CH_CTR_LOOP_BITS_ENABLE
         | DMA_CH_CTR_PRI_BITS_MEDIUM
         ;
@@ -82,17 +120,131 @@ void UART_Init(void)
     DMA_CTR = (DMA_CTR & ~DMA_CTR_DMAEN_MASK) | DMA_CTR_DMAEN_BITS_ENABLE;
 
     UART1->CTRL |= UART_CTRL_UARTEN_BITS_ENABLE;
+
+    NVIC_EnableIRQ((IRQn_Type)DP32_DMA_IRQn);
+}
+
+// The ring is looked after from the DMA interrupt and, as commands are
+// handled with interrupts off, from UART_Send() itself while it waits
+// for room. Both run with interrupts masked.
+
+static void TxStart(void)
+{
+    uint16_t Size;
+
+    if (gTxChunk != 0 || gTxHead == gTxTail)
+        return;
+
+    Size = (gTxHead > gTxTail) ? gTxHead - gTxTail : UART_TX_RING_SIZE - gTxTail;
+
+    DMA_CH1->CTR    = 0;
+    DMA_CH1->MSADDR = (uint32_t)(uintptr_t)&gTxRing[gTxTail];
+    DMA_CH1->CTR    = 0
+        | DMA_CH_CTR_CH_EN_BITS_ENABLE
+        | (((Size - 1U) << DMA_CH_CTR_LENGTH_SHIFT) & DMA_CH_CTR_LENGTH_MASK)
+        | DMA_CH_CTR_LOOP_BITS_DISABLE
+        | DMA_CH_CTR_PRI_BITS_LOW
+        ;
+
+    gTxChunk = Size;
+}
+
+static void TxService(void)
+{
+    if (gTxChunk != 0 && (DMA_INTST & DMA_INTST_CH1_TC_INTST_MASK) != DMA_INTST_CH1_TC_INTST_BITS_NOT_SET) {
+        DMA_INTST = DMA_INTST_CH1_TC_INTST_BITS_SET;
+        gTxTail   = (gTxTail + gTxChunk) % UART_TX_RING_SIZE;
+        gTxChunk  = 0;
+    }
+
+    TxStart();
+}
+
+static void TxPoll(void)
+{
+    const uint32_t Mask = __get_PRIMASK();
+
+    __disable_irq();
+    TxService();
+    __set_PRIMASK(Mask);
+}
+
+void HandlerDMA(void);
+
+void HandlerDMA(void)
+{
+    TxService();
+}
+
+// everything queued so far has been handed to the UART
+bool UART_IsSendComplete(void)
+{
+    return gTxChunk == 0 && gTxHead == gTxTail;
+}
+
+// wait until everything queued has left the wire
+void UART_Flush(void)
+{
+    while (!UART_IsSendComplete())
+        TxPoll();
+
+    while ((UART1->IF & UART_IF_TXFIFO_EMPTY_MASK) == UART_IF_TXFIFO_EMPTY_BITS_NOT_SET ||
+           (UART1->IF & UART_IF_TXBUSY_MASK) != UART_IF_TXBUSY_BITS_NOT_SET) {
+    }
+}
+
+// switch the rate once everything queued has left, what arrives in the
+// meantime goes on landing in the DMA buffer
+void UART_SetBaudRate(uint32_t BaudRate)
+{
+    UART_Flush();
+
+    UART1->CTRL = (UART1->CTRL & ~UART_CTRL_UARTEN_MASK) | UART_CTRL_UARTEN_BITS_DISABLE;
+    UART1->BAUD = Divisor(BaudRate);
+    UART1->CTRL |= UART_CTRL_UARTEN_BITS_ENABLE;
 }
 
+// Ring index the receive DMA will write next. The status register counts
+// the bytes moved in the current loop in its low 12 bits, whatever the
+// ring size, and may read as the full length just before it wraps.
+uint16_t UART_RxIndex(void)
+{
+    return (DMA_CH0->ST & 0xFFFU) % UART_RX_RING_SIZE;
+}
+
+// Queue Size bytes for transmission. Only waits when the ring is full.
 void UART_Send(const void *pBuffer, uint32_t Size)
 {
     const uint8_t *pData = (const uint8_t *)pBuffer;
-    uint32_t i;
 
-    for (i = 0; i < Size; i++) {
-        UART1->TDR = pData[i];
-        while ((UART1->IF & UART_IF_TXFIFO_FULL_MASK) != UART_IF_TXFIFO_FULL_BITS_NOT_SET) {
+    while (Size > 0) {
+        const uint16_t Tail = gTxTail;
+        uint32_t       Room;
+
+        // one slot stays free to tell a full ring from an empty one
+        if (gTxHead >= Tail)
+            Room = UART_TX_RING_SIZE - gTxHead - (Tail == 0 ? 1 : 0);
+        else
+            Room = Tail - gTxHead - 1;
+
+        if (Room == 0) {
+            TxPoll();
+            continue;
         }
+
+        if (Room > Size)
+            Room = Size;
+
+        for (uint32_t i = 0; i < Room; i++)
+            gTxRing[gTxHead + i] = pData[i];
+
+        // the bytes must be in place before the DMA may see them
+        __DMB();
+        gTxHead = (gTxHead + Room) % UART_TX_RING_SIZE;
+        pData  += Room;
+        Size   -= Room;
+
+        TxPoll();
     }
 }
 
@@ -18,12 +18,29 @@
 #ifndef DRIVER_UART_H
 #define DRIVER_UART_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
-extern uint8_t UART_DMA_Buffer[256];
+#define UART_BAUD_RATE_DEFAULT 38400
+
+// receive ring filled by DMA channel 0, it bounds the largest command
+// and how much the host may send ahead of the replies
+#ifndef UART_RX_RING_SIZE
+    #define UART_RX_RING_SIZE 256
+#endif
+
+#ifndef UART_TX_RING_SIZE
+    #define UART_TX_RING_SIZE 256
+#endif
+
+extern uint8_t UART_DMA_Buffer[UART_RX_RING_SIZE];
 
 void UART_Init(void);
+void UART_SetBaudRate(uint32_t BaudRate);
+uint16_t UART_RxIndex(void);
 void UART_Send(const void *pBuffer, uint32_t Size);
+bool UART_IsSendComplete(void);
+void UART_Flush(void);
 void UART_LogSend(const void *pBuffer, uint32_t Size);
 
 #endif
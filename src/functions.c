@@ -27,12 +27,14 @@
     #include "driver/bk1080.h"
 #endif
 #include "driver/bk4819.h"
+#include "driver/eeprom.h"
 #include "driver/gpio.h"
 #include "driver/system.h"
 #include "driver/st7565.h"
 #include "frequencies.h"
 #include "functions.h"
 #include "helper/battery.h"
+#include "helper/trace.h"
 #include "misc.h"
 #include "radio.h"
 #include "settings.h"
@@ -178,6 +180,8 @@ void FUNCTION_Select(FUNCTION_Type_t Function)
 
     gCurrentFunction = Function;
 
+    TRACE(TRACE_FUNCTION, Function, PreviousFunction);
+
     if (bWasPowerSave && Function != FUNCTION_POWER_SAVE) {
         BK4819_Conditional_RX_TurnOn_and_GPIO6_Enable();
         gRxIdleMode = false;
@@ -190,6 +194,9 @@ void FUNCTION_Select(FUNCTION_Type_t Function)
             return;
 
         case FUNCTION_POWER_SAVE:
+            // the radio may be switched off from here on
+            SETTINGS_CommitSettings();
+            EEPROM_Flush();
             FUNCTION_PowerSave();
             return;
 
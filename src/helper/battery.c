@@ -20,12 +20,12 @@
 #include "driver/backlight.h"
 #include "driver/st7565.h"
 #include "functions.h"
+#include "helper/trace.h"
 #include "misc.h"
 #include "settings.h"
 #include "ui/battery.h"
 #include "ui/menu.h"
 #include "ui/ui.h"
-//#include "debugging.h"
 
 uint16_t          gBatteryCalibration[6];
 uint16_t          gBatteryCurrentVoltage;
@@ -122,14 +122,10 @@ void BATTERY_GetReadings(const bool bDisplayBatteryLevel)
         gBatteryDisplayLevel = 1;
         const uint8_t levels[] = {5,17,41,65,88};
         uint8_t perc = BATTERY_VoltsToPercent(gBatteryVoltageAverage);
-        //char str[64];
-        //LogUart("----------\n");
-        //sprintf(str, "%d %d %d %d %d %d %d\n", gBatteryVoltages[0], gBatteryVoltages[1], gBatteryVoltages[2], gBatteryVoltages[3], Voltage, gBatteryVoltageAverage, perc);
-        //LogUart(str);
+
+        TRACE(TRACE_BATTERY, gBatteryVoltageAverage, perc);
 
         for(uint8_t i = 6; i >= 2; i--){
-            //sprintf(str, "%d %d %d\n", perc, levels[i-2], i);
-            //LogUart(str);
             if (perc > levels[i-2]) {
                 gBatteryDisplayLevel = i;
                 break;
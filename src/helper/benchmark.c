@@ -0,0 +1,54 @@
+#ifdef ENABLE_EEPROM_BENCHMARK
+
+#include "debugging.h"
+#include "driver/eeprom.h"
+#include "driver/i2c.h"
+#include "driver/systick.h"
+#include "helper/benchmark.h"
+
+#define EEPROM_SIZE 0x2000
+
+// the transfer as it was done before the streaming API: one standard
+// timed transaction per Size bytes
+static void ReadStandard(uint16_t Address, void *pBuffer, uint8_t Size)
+{
+    I2C_Start();
+    I2C_Write(0xA0);
+    I2C_Write((Address >> 8) & 0xFF);
+    I2C_Write((Address >> 0) & 0xFF);
+    I2C_Start();
+    I2C_Write(0xA1);
+    I2C_ReadBuffer(pBuffer, Size);
+    I2C_Stop();
+}
+
+static void Report(const char *pName, uint32_t Start)
+{
+    const uint32_t us = SYSTICK_GetUs() - Start;
+    LogUartf("%s: %u us, %u B/s\r\n", pName, us, (uint32_t)((uint64_t)EEPROM_SIZE * 1000000u / us));
+}
+
+// reads the whole EEPROM a few ways and logs the throughput over UART
+void BENCHMARK_EEPROM(void)
+{
+    uint8_t  buf[128];
+    uint32_t start;
+
+    start = SYSTICK_GetUs();
+    for (uint16_t a = 0; a < EEPROM_SIZE; a += 8)
+        ReadStandard(a, buf, 8);
+    Report("EEPROM 8 B reads  ", start);
+
+    start = SYSTICK_GetUs();
+    for (uint16_t a = 0; a < EEPROM_SIZE; a += sizeof(buf))
+        ReadStandard(a, buf, sizeof(buf));
+    Report("EEPROM 128 B reads", start);
+
+    start = SYSTICK_GetUs();
+    EEPROM_StreamBegin(0, EEPROM_SIZE);
+    for (uint16_t a = 0; a < EEPROM_SIZE; a += sizeof(buf))
+        EEPROM_StreamRead(buf, sizeof(buf));
+    Report("EEPROM stream     ", start);
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HELPER_BENCHMARK_H
+#define HELPER_BENCHMARK_H
+
+#ifdef ENABLE_EEPROM_BENCHMARK
+
+#ifndef ENABLE_UART
+    #error "ENABLE_EEPROM_BENCHMARK needs ENABLE_UART"
+#endif
+
+void BENCHMARK_EEPROM(void);
+#endif
+
+#endif
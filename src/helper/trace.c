@@ -0,0 +1,89 @@
+#ifdef ENABLE_TRACE
+
+#include "ARMCM0.h"
+#include "helper/trace.h"
+#include "misc.h"
+
+// events queued at most, a power of two below 256; later ones are
+// dropped and counted until the UART has caught up
+#define TRACE_RING_SIZE 32
+
+static TRACE_Record_t gTraceRing[TRACE_RING_SIZE];
+static uint8_t        gTraceHead;
+static uint8_t        gTraceTail;
+static uint16_t       gTraceDropped;
+
+static void Push(uint32_t Tick, uint16_t Cycles_8, TRACE_Event_t Event, uint32_t Arg0, uint32_t Arg1)
+{
+    TRACE_Record_t *pRecord = &gTraceRing[gTraceHead % TRACE_RING_SIZE];
+
+    pRecord->Tick_10ms = Tick;
+    pRecord->Cycles_8  = Cycles_8;
+    pRecord->Event     = Event;
+    pRecord->Padding   = 0;
+    pRecord->Arg[0]    = Arg0;
+    pRecord->Arg[1]    = Arg1;
+    gTraceHead++;
+}
+
+// Queue an event. Costs a time stamp and a 16 byte copy, no formatting,
+// so it can stay in the scan and receive paths. Safe from interrupts.
+void TRACE_Event(TRACE_Event_t Event, uint32_t Arg0, uint32_t Arg1)
+{
+    uint32_t Tick;
+    uint32_t Value;
+
+    do {    // retry if the 10 ms interrupt fired in between
+        Tick  = gGlobalSysTickCounter;
+        Value = SysTick->VAL;
+    } while (Tick != gGlobalSysTickCounter);
+
+    const uint16_t Cycles_8 = (SysTick->LOAD - Value) >> 3;
+    const uint32_t Mask     = __get_PRIMASK();
+
+    __disable_irq();
+
+    const uint8_t Free = TRACE_RING_SIZE - (uint8_t)(gTraceHead - gTraceTail);
+
+    // events lost to a full queue are told of in their place in time,
+    // once there is room again for that and the event itself
+    if (gTraceDropped > 0) {
+        if (Free < 2) {
+            gTraceDropped++;
+        }
+        else {
+            Push(Tick, Cycles_8, TRACE_DROPPED, gTraceDropped, 0);
+            Push(Tick, Cycles_8, Event, Arg0, Arg1);
+            gTraceDropped = 0;
+        }
+    }
+    else if (Free == 0) {
+        gTraceDropped++;
+    }
+    else {
+        Push(Tick, Cycles_8, Event, Arg0, Arg1);
+    }
+
+    __set_PRIMASK(Mask);
+}
+
+// Take the oldest event off the queue, false when there is none.
+bool TRACE_Fetch(TRACE_Record_t *pRecord)
+{
+    const uint32_t Mask     = __get_PRIMASK();
+    bool           bFetched = false;
+
+    __disable_irq();
+
+    if (gTraceHead != gTraceTail) {
+        *pRecord = gTraceRing[gTraceTail % TRACE_RING_SIZE];
+        gTraceTail++;
+        bFetched = true;
+    }
+
+    __set_PRIMASK(Mask);
+
+    return bFetched;
+}
+
+#endif
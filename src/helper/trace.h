@@ -0,0 +1,47 @@
+#ifndef HELPER_TRACE_H
+#define HELPER_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Binary trace events: an ID and two integer arguments, time stamped
+// and queued in RAM, drained over the UART while the link is idle.
+// utils/trace_decode.py reads the names and argument labels from the
+// comments below, so only ever append to this list.
+typedef enum {
+    TRACE_DROPPED = 0,          // count
+    TRACE_BOOT,                 // mode
+    TRACE_FUNCTION,             // function, previous
+    TRACE_SCAN_PRIORITY,        // list, channel
+    TRACE_SCAN_CHANNEL,         // channel
+    TRACE_SCAN_FREQUENCY,       // frequency
+    TRACE_SCAN_FOUND,           // channel_or_frequency
+    TRACE_BATTERY,              // voltage, percent
+} TRACE_Event_t;
+
+typedef struct {
+    uint32_t Tick_10ms;         // gGlobalSysTickCounter
+    uint16_t Cycles_8;          // SysTick cycles into the tick, / 8
+    uint8_t  Event;             // TRACE_Event_t
+    uint8_t  Padding;
+    uint32_t Arg[2];
+} TRACE_Record_t;
+
+#ifdef ENABLE_TRACE
+
+#ifndef ENABLE_UART
+    #error "ENABLE_TRACE needs ENABLE_UART"
+#endif
+
+void TRACE_Event(TRACE_Event_t Event, uint32_t Arg0, uint32_t Arg1);
+bool TRACE_Fetch(TRACE_Record_t *pRecord);
+
+#define TRACE(Event, Arg0, Arg1) TRACE_Event(Event, Arg0, Arg1)
+
+#else
+
+#define TRACE(Event, Arg0, Arg1) do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+#include <string.h>
+
+#include "driver/eeprom.h"
+#include "journal.h"
+#include "misc.h"
+#include "settings.h"
+
+#define JOURNAL_BASE        0x1D00
+#define JOURNAL_RECORDS     16
+#define JOURNAL_RECORD_SIZE 16
+
+// home locations the journal stands in for
+#define VFO_RECORD_BASE     0x0C80
+#define VFO_INDICES         0x0E80
+
+// record type, otherwise the VFO frequency slot the record carries
+#define TYPE_INDICES        0xFF    // indices only
+#define TYPE_CHECKPOINT     0xFE    // the home locations are current
+
+// frequency of a slot record telling the home location is current again
+#define FREQUENCY_HOME      0xFFFFFFFF
+
+// one per band per VFO
+#define SLOT_COUNT          ((FREQ_CHANNEL_LAST - FREQ_CHANNEL_FIRST + 1) * 2)
+
+typedef struct {
+    uint8_t  Sequence;
+    uint8_t  Type;
+    uint8_t  Indices[6];
+    uint32_t Frequency;
+    uint8_t  Unused[3];
+    uint8_t  Check;
+} __attribute__((packed)) JournalRecord_t;
+
+_Static_assert(sizeof(JournalRecord_t) == JOURNAL_RECORD_SIZE, "journal record size");
+
+// journaled frequency of each slot, 0 when the home location is current
+static uint32_t gFrequency[SLOT_COUNT];
+// ring position of the record holding it
+static uint8_t  gOwner[SLOT_COUNT];
+static uint8_t  gNext;
+static uint8_t  gSequence;
+// records newer than the last checkpoint exist
+static bool     gAhead;
+
+static uint8_t Checksum(const JournalRecord_t *pRecord)
+{
+    const uint8_t *p   = (const uint8_t *)pRecord;
+    uint8_t        sum = 0;
+
+    for (unsigned int i = 0; i < JOURNAL_RECORD_SIZE - 1; i++)
+        sum += p[i];
+
+    return ~sum;
+}
+
+static uint8_t Slot(uint8_t Channel, uint8_t VFO)
+{
+    return (Channel - FREQ_CHANNEL_FIRST) + (VFO ? SLOT_COUNT / 2 : 0);
+}
+
+static uint16_t SlotAddress(uint8_t Slot)
+{
+    const uint8_t band = Slot % (SLOT_COUNT / 2);
+    const uint8_t vfo  = Slot / (SLOT_COUNT / 2);
+    return VFO_RECORD_BASE + band * 32 + vfo * 16;
+}
+
+// write a journaled frequency back to its home location
+static void FoldSlot(uint8_t Slot)
+{
+    uint32_t info[2];
+    const uint16_t address = SlotAddress(Slot);
+
+    EEPROM_ReadBuffer(address, info, sizeof(info));
+    info[0] = gFrequency[Slot];
+    EEPROM_WriteBuffer(address, info);
+
+    gFrequency[Slot] = 0;
+}
+
+static void Append(uint8_t Type, const uint8_t *pIndices, uint32_t Frequency)
+{
+    JournalRecord_t record;
+    const uint8_t   pos = gNext;
+    bool            folded = false;
+
+    // the record about to be overwritten may be the last word on a slot
+    for (uint8_t s = 0; s < SLOT_COUNT; s++) {
+        if (gFrequency[s] != 0 && gOwner[s] == pos && s != Type) {
+            FoldSlot(s);
+            folded = true;
+        }
+    }
+
+    // The page buffer flushes in no particular order, but a record must
+    // not reach the chip before what it builds on: the home locations
+    // just folded, and the records before it (one lost in a power cut
+    // would leave the later ones to be taken for the newest at boot).
+    // Flush before starting on another page of the ring.
+    if (folded || (pos % (EEPROM_PAGE_SIZE / JOURNAL_RECORD_SIZE) == 0 && EEPROM_IsDirty()))
+        EEPROM_Flush();
+
+    record.Sequence  = gSequence;
+    record.Type      = Type;
+    memcpy(record.Indices, pIndices, sizeof(record.Indices));
+    record.Frequency = Frequency;
+    memset(record.Unused, 0xFF, sizeof(record.Unused));
+    record.Check     = Checksum(&record);
+
+    // both halves share a page: one page write once flushed
+    EEPROM_WriteBuffer(JOURNAL_BASE + pos * JOURNAL_RECORD_SIZE + 0, (const uint8_t *)&record + 0);
+    EEPROM_WriteBuffer(JOURNAL_BASE + pos * JOURNAL_RECORD_SIZE + 8, (const uint8_t *)&record + 8);
+
+    gNext = (pos + 1) % JOURNAL_RECORDS;
+    gSequence++;
+    gAhead = (Type != TYPE_CHECKPOINT);
+}
+
+static void CurrentIndices(uint8_t *pIndices)
+{
+    pIndices[0] = gEeprom.ScreenChannel[0];
+    pIndices[1] = gEeprom.MrChannel[0];
+    pIndices[2] = gEeprom.FreqChannel[0];
+    pIndices[3] = gEeprom.ScreenChannel[1];
+    pIndices[4] = gEeprom.MrChannel[1];
+    pIndices[5] = gEeprom.FreqChannel[1];
+}
+
+// Scan the ring, rebuild the RAM state and patch the six index bytes read
+// from 0x0E80 with the newest journaled ones.
+void JOURNAL_Init(uint8_t *pIndices)
+{
+    JournalRecord_t record;
+    uint8_t         sequence[JOURNAL_RECORDS];
+    uint8_t         type[JOURNAL_RECORDS];
+    uint32_t        frequency[JOURNAL_RECORDS];
+    uint16_t        valid = 0;
+    uint8_t         newest;
+    uint8_t         first;
+
+    memset(gFrequency, 0, sizeof(gFrequency));
+    gNext     = 0;
+    gSequence = 0;
+    gAhead    = false;
+
+    EEPROM_StreamBegin(JOURNAL_BASE, JOURNAL_RECORDS * JOURNAL_RECORD_SIZE);
+    for (uint8_t i = 0; i < JOURNAL_RECORDS; i++) {
+        EEPROM_StreamRead(&record, sizeof(record));
+        if (record.Check == Checksum(&record))
+            valid |= 1u << i;
+        sequence[i]  = record.Sequence;
+        type[i]      = record.Type;
+        frequency[i] = record.Frequency;
+    }
+
+    if (valid == 0)
+        return;
+
+    // records are written in ring order with consecutive sequence
+    // numbers: the newest is the one its successor does not follow
+    for (newest = 0; newest < JOURNAL_RECORDS; newest++) {
+        const uint8_t next = (newest + 1) % JOURNAL_RECORDS;
+        if ((valid & (1u << newest)) &&
+            (!(valid & (1u << next)) || sequence[next] != (uint8_t)(sequence[newest] + 1)))
+            break;
+    }
+    if (newest == JOURNAL_RECORDS)
+        return;
+
+    // walk back over the unbroken run, no further than the last checkpoint
+    first = newest;
+    for (uint8_t n = 1; n < JOURNAL_RECORDS && type[first] != TYPE_CHECKPOINT; n++) {
+        const uint8_t prev = (first + JOURNAL_RECORDS - 1) % JOURNAL_RECORDS;
+        if (!(valid & (1u << prev)) || sequence[prev] != (uint8_t)(sequence[first] - 1))
+            break;
+        first = prev;
+    }
+
+    for (uint8_t pos = first; ; pos = (pos + 1) % JOURNAL_RECORDS) {
+        const uint8_t s = type[pos];
+        if (s < SLOT_COUNT) {
+            gFrequency[s] = (frequency[pos] == FREQUENCY_HOME) ? 0 : frequency[pos];
+            gOwner[s]     = pos;
+        }
+        if (pos == newest)
+            break;
+    }
+
+    EEPROM_ReadBuffer(JOURNAL_BASE + newest * JOURNAL_RECORD_SIZE, &record, sizeof(record));
+    memcpy(pIndices, record.Indices, sizeof(record.Indices));
+
+    gNext     = (newest + 1) % JOURNAL_RECORDS;
+    gSequence = sequence[newest] + 1;
+    gAhead    = (type[newest] != TYPE_CHECKPOINT);
+}
+
+void JOURNAL_SaveIndices(void)
+{
+    uint8_t indices[6];
+    CurrentIndices(indices);
+    Append(TYPE_INDICES, indices, FREQUENCY_HOME);
+}
+
+void JOURNAL_SaveFrequency(uint8_t Channel, uint8_t VFO, uint32_t Frequency)
+{
+    uint8_t indices[6];
+
+    if (!IS_FREQ_CHANNEL(Channel) || Frequency == 0 || Frequency == FREQUENCY_HOME)
+        return;
+
+    const uint8_t s = Slot(Channel, VFO);
+
+    CurrentIndices(indices);
+    Append(s, indices, Frequency);
+
+    gFrequency[s] = Frequency;
+    gOwner[s]     = (gNext + JOURNAL_RECORDS - 1) % JOURNAL_RECORDS;
+}
+
+// the home location of a VFO was just written, older journaled
+// frequencies for it must not override it at the next boot
+void JOURNAL_Forget(uint8_t Channel, uint8_t VFO)
+{
+    uint8_t indices[6];
+
+    if (!IS_FREQ_CHANNEL(Channel))
+        return;
+
+    const uint8_t s = Slot(Channel, VFO);
+    if (gFrequency[s] == 0)
+        return;
+
+    // the home location before the record saying it is current
+    EEPROM_Flush();
+
+    gFrequency[s] = 0;
+    CurrentIndices(indices);
+    Append(s, indices, FREQUENCY_HOME);
+}
+
+bool JOURNAL_GetFrequency(uint8_t Channel, uint8_t VFO, uint32_t *pFrequency)
+{
+    if (!IS_FREQ_CHANNEL(Channel))
+        return false;
+
+    const uint8_t s = Slot(Channel, VFO);
+    if (gFrequency[s] == 0)
+        return false;
+
+    *pFrequency = gFrequency[s];
+    return true;
+}
+
+// bring the home locations up to date, e.g. before they are read out
+void JOURNAL_Fold(void)
+{
+    uint8_t indices[8];
+
+    if (!gAhead)
+        return;
+
+    for (uint8_t s = 0; s < SLOT_COUNT; s++)
+        if (gFrequency[s] != 0)
+            FoldSlot(s);
+
+    EEPROM_ReadBuffer(VFO_INDICES, indices, sizeof(indices));
+    CurrentIndices(indices);
+    EEPROM_WriteBuffer(VFO_INDICES, indices);
+
+    JOURNAL_Reset();
+}
+
+// the home locations were rewritten behind our back (programming
+// software, factory reset), everything journaled so far is void
+void JOURNAL_Reset(void)
+{
+    uint8_t indices[8];
+
+    memset(gFrequency, 0, sizeof(gFrequency));
+
+    // the home locations before the checkpoint vouching for them
+    EEPROM_Flush();
+
+    EEPROM_ReadBuffer(VFO_INDICES, indices, sizeof(indices));
+    Append(TYPE_CHECKPOINT, indices, FREQUENCY_HOME);
+}
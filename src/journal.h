@@ -0,0 +1,24 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Append-only journal for the VFO state that changes all the time (the
+// VFO/channel indices and the frequency a scan stopped on). Every save
+// appends one 16 byte record to a ring at 0x1D00..0x1DFF instead of
+// rewriting the same bytes in the settings and VFO areas, so the wear
+// is spread over the ring and each save costs a single page write.
+// The home locations are only brought up to date when a record is about
+// to be overwritten, or when somebody else (the programming software)
+// wants to look at them.
+
+void JOURNAL_Init(uint8_t *pIndices);
+void JOURNAL_SaveIndices(void);
+void JOURNAL_SaveFrequency(uint8_t Channel, uint8_t VFO, uint32_t Frequency);
+void JOURNAL_Forget(uint8_t Channel, uint8_t VFO);
+bool JOURNAL_GetFrequency(uint8_t Channel, uint8_t VFO, uint32_t *pFrequency);
+void JOURNAL_Fold(void);
+void JOURNAL_Reset(void);
+
+#endif
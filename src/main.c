@@ -22,9 +22,14 @@
 #include "board.h"
 #include "misc.h"
 #include "radio.h"
+#ifdef ENABLE_SCAN_LOG
+    #include "scanlog.h"
+#endif
 #include "settings.h"
 #include "version.h"
 
+#include "external/printf/printf.h"
+
 #include "app/app.h"
 #include "app/dtmf.h"
 #include "bsp/dp32g030/gpio.h"
@@ -41,7 +46,9 @@
 #endif
 
 #include "helper/battery.h"
+#include "helper/benchmark.h"
 #include "helper/boot.h"
+#include "helper/trace.h"
 
 #include "ui/welcome.h"
 #include "ui/menu.h"
@@ -58,6 +65,10 @@ void Main(void) {
     UART_Send(UART_Version, strlen(UART_Version));
 #endif
 
+#ifdef ENABLE_EEPROM_BENCHMARK
+    BENCHMARK_EEPROM();
+#endif
+
     // Not implementing authentic device checks
     memset(gDTMF_String, '-', sizeof(gDTMF_String));
     gDTMF_String[sizeof(gDTMF_String) - 1] = 0;
@@ -66,8 +77,13 @@ void Main(void) {
 
     BOARD_ADC_GetBatteryInfo(&gBatteryCurrentVoltage, &gBatteryCurrent);
 
+    EEPROM_DetectSize();
     SETTINGS_InitEEPROM();
 
+#ifdef ENABLE_SCAN_LOG
+    SCANLOG_Init();
+#endif
+
     gDW = gEeprom.DUAL_WATCH;
     gCB = gEeprom.CROSS_BAND_RX_TX;
 
@@ -90,12 +106,14 @@ void Main(void) {
 
     const BOOT_Mode_t  BootMode = BOOT_GetMode();
 
+    TRACE(TRACE_BOOT, BootMode, 0);
+
     if (BootMode == BOOT_MODE_F_LOCK)
     {
         gF_LOCK = true;            // flag to say include the hidden menu items
         gEeprom.KEY_LOCK = 0;
         SETTINGS_SaveSettings();
-        gMenuCursor = 67; // move to hidden section, fix me if change... !!!
+        gMenuCursor = UI_MENU_GetMenuIdx(FIRST_HIDDEN_MENU_ITEM); // move to hidden section
         gSubMenuSelection = gSetting_F_LOCK;
     }
 
@@ -142,6 +160,20 @@ void Main(void) {
     {
         UI_DisplayWelcome();
 
+        gBootTime_ms = SYSTICK_GetUs() / 1000;
+#ifdef ENABLE_UART
+        {   // report time-to-first-screen
+            char String[24];
+            sprintf(String, "Boot %ums\r\n", gBootTime_ms);
+            UART_Send(String, strlen(String));
+
+            if (gSettingsLoadStatus == SETTINGS_LOAD_MIGRATED)
+                UART_Send("Settings migrated\r\n", 19);
+            else if (gSettingsLoadStatus == SETTINGS_LOAD_REPAIRED)
+                UART_Send("Settings repaired\r\n", 19);
+        }
+#endif
+
         BACKLIGHT_TurnOn();
 
         if (gEeprom.POWER_ON_DISPLAY_MODE != POWER_ON_DISPLAY_MODE_NONE)
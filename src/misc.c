@@ -111,7 +111,6 @@ uint16_t          gEEPROM_1F8A;
 uint16_t          gEEPROM_1F8C;
 
 ChannelAttributes_t gMR_ChannelAttributes[FREQ_CHANNEL_LAST + 1];
-bool                gMR_ChannelExclude[FREQ_CHANNEL_LAST + 1];
 
 volatile uint16_t gBatterySaveCountdown_10ms = battery_save_count_10ms;
 
@@ -208,6 +207,8 @@ bool              gUpdateDisplay;
 
 bool              gF_LOCK = false;
 
+uint16_t          gBootTime_ms;
+
 uint8_t           gShowChPrefix;
 
 volatile bool     gNextTimeslice;
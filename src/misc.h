@@ -184,7 +184,6 @@ typedef union {
 } ChannelAttributes_t;
 
 extern ChannelAttributes_t   gMR_ChannelAttributes[207];
-extern bool                  gMR_ChannelExclude[207];
 
 extern volatile uint16_t     gBatterySaveCountdown_10ms;
 
@@ -200,6 +199,9 @@ extern volatile uint8_t      gSerialConfigCountDown_500ms;
 
 extern volatile bool         gNextTimeslice_500ms;
 
+// 10 ms SysTick interrupts since boot
+extern volatile uint32_t     gGlobalSysTickCounter;
+
 extern volatile uint16_t     gTxTimerCountdown_500ms;
 extern volatile bool         gTxTimeoutReached;
 
@@ -291,6 +293,8 @@ extern uint8_t               gFSKWriteIndex;
 extern volatile bool         gNextTimeslice;
 extern bool                  gUpdateDisplay;
 extern bool                  gF_LOCK;
+// time from reset to the first screen being drawn
+extern uint16_t              gBootTime_ms;
 #ifdef ENABLE_FMRADIO
     extern uint8_t           gFM_ChannelPosition;
 #endif
@@ -19,10 +19,14 @@
 
 #include "am_fix.h"
 #include "app/dtmf.h"
+#ifdef ENABLE_UART
+    #include "app/uart.h"
+#endif
 #ifdef ENABLE_FMRADIO
     #include "app/fm.h"
 #endif
 #include "bsp/dp32g030/gpio.h"
+#include "chcache.h"
 #include "dcs.h"
 #include "driver/bk4819.h"
 #include "driver/eeprom.h"
@@ -31,8 +35,10 @@
 #include "frequencies.h"
 #include "functions.h"
 #include "helper/battery.h"
+#include "journal.h"
 #include "misc.h"
 #include "radio.h"
+#include "scanlist.h"
 #include "settings.h"
 #include "ui/menu.h"
 #include "audio.h"
@@ -60,52 +66,22 @@ bool RADIO_CheckValidChannel(uint16_t channel, bool checkScanList, uint8_t scanL
     if (!IS_MR_CHANNEL(channel))
         return false;
 
-    const ChannelAttributes_t att = gMR_ChannelAttributes[channel];
-
-    if (checkScanList && gMR_ChannelExclude[channel] == true)
+    if (checkScanList && CHANNELSET_Contains(&gMR_ChannelExclude, channel))
         return false;
 
-    if (att.band > BAND7_470MHz)
+    if (!CHANNELSET_Contains(&gMR_ChannelValid, channel))
         return false;
 
-    if (!checkScanList || scanList > 4)
+    if (!checkScanList || scanList > SCAN_LIST_COUNT + 1)
         return true;
 
-    /*
-    if(scanList == 0 && (att.scanlist1 == 1 || att.scanlist2 == 1 || att.scanlist3 == 1))
-    {
-        return false;
-    }
-    else if(scanList == 1 && att.scanlist1 != 1)
-    {
+    if (!SCANLIST_IsMember(channel, scanList))
         return false;
-    }
-    else if(scanList == 2 && att.scanlist2 != 1)
-    {
-        return false;
-    }
-    else if(scanList == 3 && att.scanlist3 != 1)
-    {
-        return false;
-    }
-    else if(scanList == 4 && (att.scanlist1 == 0 && att.scanlist2 == 0 && att.scanlist3 == 0))
-    {
-        return false;
-    }
-    */
-
-    if ((scanList == 0 && (att.scanlist1 == 1 || att.scanlist2 == 1 || att.scanlist3 == 1)) ||
-        (scanList == 1 && att.scanlist1 != 1) ||
-        (scanList == 2 && att.scanlist2 != 1) ||
-        (scanList == 3 && att.scanlist3 != 1) ||
-        (scanList == 4 && (att.scanlist1 == 0 && att.scanlist2 == 0 && att.scanlist3 == 0))) {
-        return false;
-    }
 
-    //return true;
+    if (scanList < 1 || scanList > SCAN_LIST_COUNT)
+        return true;
 
-    // I don't understand what this code is for...
-    
+    // priority channels are scanned on their own, skip them in the list
     const uint8_t PriorityCh1 = gEeprom.SCANLIST_PRIORITY_CH1[scanList - 1];
     const uint8_t PriorityCh2 = gEeprom.SCANLIST_PRIORITY_CH2[scanList - 1];
 
@@ -209,9 +185,9 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
     bool bParticipation3;
 
     if (IS_MR_CHANNEL(channel)) {
-        bParticipation1 = att.scanlist1;
-        bParticipation2 = att.scanlist2;
-        bParticipation3 = att.scanlist3;
+        bParticipation1 = CHANNELSET_Contains(&gMR_ScanList[0], channel);
+        bParticipation2 = CHANNELSET_Contains(&gMR_ScanList[1], channel);
+        bParticipation3 = CHANNELSET_Contains(&gMR_ScanList[2], channel);
     }
     else {
         band = channel - FREQ_CHANNEL_FIRST;
@@ -226,132 +202,43 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
     pVfo->SCANLIST3_PARTICIPATION = bParticipation3;
     pVfo->CHANNEL_SAVE            = channel;
 
-    uint16_t base;
-    if (IS_MR_CHANNEL(channel))
-        base = channel * 16;
-    else
-        base = 0x0C80 + ((channel - FREQ_CHANNEL_FIRST) * 32) + (VFO * 16);
-
     if (configure == VFO_CONFIGURE_RELOAD || IS_FREQ_CHANNEL(channel))
     {
-        uint8_t tmp;
-        uint8_t data[8];
-        
-        // ***************
-
-        EEPROM_ReadBuffer(base + 8, data, sizeof(data));
-
-        tmp = data[3] & 0x0F;
-        if (tmp > TX_OFFSET_FREQUENCY_DIRECTION_SUB)
-            tmp = 0;
-        pVfo->TX_OFFSET_FREQUENCY_DIRECTION = tmp;
-        tmp = data[3] >> 4;
-        if (tmp >= MODULATION_UKNOWN)
-            tmp = MODULATION_FM;
-        pVfo->Modulation = tmp;
-
-        tmp = data[6];
-        if (tmp >= STEP_N_ELEM)
-            tmp = STEP_12_5kHz;
-        pVfo->STEP_SETTING  = tmp;
-        pVfo->StepFrequency = gStepFrequencyTable[tmp];
-
-        tmp = data[7];
-        pVfo->SCRAMBLING_TYPE = 0;
-
-        pVfo->freq_config_RX.CodeType = (data[2] >> 0) & 0x0F;
-        pVfo->freq_config_TX.CodeType = (data[2] >> 4) & 0x0F;
-
-        tmp = data[0];
-        switch (pVfo->freq_config_RX.CodeType)
-        {
-            default:
-            case CODE_TYPE_OFF:
-                pVfo->freq_config_RX.CodeType = CODE_TYPE_OFF;
-                tmp = 0;
-                break;
-
-            case CODE_TYPE_CONTINUOUS_TONE:
-                if (tmp > (ARRAY_SIZE(CTCSS_Options) - 1))
-                    tmp = 0;
-                break;
-
-            case CODE_TYPE_DIGITAL:
-            case CODE_TYPE_REVERSE_DIGITAL:
-                if (tmp > (ARRAY_SIZE(DCS_Options) - 1))
-                    tmp = 0;
-                break;
+        ChannelRecord_t record;
+
+        if (IS_MR_CHANNEL(channel))
+            CHCACHE_GetRecord(channel, &record);
+        else {
+            SETTINGS_FetchChannelRecord(0x0C80 + ((channel - FREQ_CHANNEL_FIRST) * 32) + (VFO * 16), &record);
+            uint32_t frequency;
+            if (JOURNAL_GetFrequency(channel, VFO, &frequency))
+                record.Frequency = frequency;
         }
-        pVfo->freq_config_RX.Code = tmp;
 
-        tmp = data[1];
-        switch (pVfo->freq_config_TX.CodeType)
-        {
-            default:
-            case CODE_TYPE_OFF:
-                pVfo->freq_config_TX.CodeType = CODE_TYPE_OFF;
-                tmp = 0;
-                break;
-
-            case CODE_TYPE_CONTINUOUS_TONE:
-                if (tmp > (ARRAY_SIZE(CTCSS_Options) - 1))
-                    tmp = 0;
-                break;
-
-            case CODE_TYPE_DIGITAL:
-            case CODE_TYPE_REVERSE_DIGITAL:
-                if (tmp > (ARRAY_SIZE(DCS_Options) - 1))
-                    tmp = 0;
-                break;
-        }
-        pVfo->freq_config_TX.Code = tmp;
-
-        if (data[4] == 0xFF)
-        {
-            pVfo->FrequencyReverse  = false;
-            pVfo->CHANNEL_BANDWIDTH = BK4819_FILTER_BW_WIDE;
-            pVfo->OUTPUT_POWER      = OUTPUT_POWER_LOW1;
-            pVfo->BUSY_CHANNEL_LOCK = false;
-            pVfo->TX_LOCK = true;
-        }
-        else
-        {
-            const uint8_t d4 = data[4];
-            pVfo->FrequencyReverse  = !!((d4 >> 0) & 1u);
-            pVfo->CHANNEL_BANDWIDTH = !!((d4 >> 1) & 1u);
-            pVfo->OUTPUT_POWER      =   ((d4 >> 2) & 7u);
-            pVfo->BUSY_CHANNEL_LOCK = !!((d4 >> 5) & 1u);
-            pVfo->TX_LOCK           = !!((d4 >> 6) & 1u);
-        }
-
-        if (data[5] == 0xFF)
-        {
-            pVfo->DTMF_PTT_ID_TX_MODE  = PTT_ID_OFF;
-        }
-        else
-        {
-            uint8_t pttId = ((data[5] >> 1) & 7u);
-            pVfo->DTMF_PTT_ID_TX_MODE  = pttId < ARRAY_SIZE(gSubMenu_PTT_ID) ? pttId : PTT_ID_OFF;
-        }
-
-        // ***************
-
-        struct {
-            uint32_t Frequency;
-            uint32_t Offset;
-        } __attribute__((packed)) info;
-        EEPROM_ReadBuffer(base, &info, sizeof(info));
-        if(info.Frequency==0xFFFFFFFF)
+        pVfo->TX_OFFSET_FREQUENCY_DIRECTION = record.OffsetDir;
+        pVfo->Modulation                    = record.Modulation;
+        pVfo->STEP_SETTING                  = record.Step;
+        pVfo->StepFrequency                 = gStepFrequencyTable[record.Step];
+        pVfo->SCRAMBLING_TYPE               = 0;
+
+        pVfo->freq_config_RX.CodeType       = record.RxCodeType;
+        pVfo->freq_config_RX.Code           = record.RxCode;
+        pVfo->freq_config_TX.CodeType       = record.TxCodeType;
+        pVfo->freq_config_TX.Code           = record.TxCode;
+
+        pVfo->FrequencyReverse              = record.Reverse;
+        pVfo->CHANNEL_BANDWIDTH             = record.Bandwidth;
+        pVfo->OUTPUT_POWER                  = record.Power;
+        pVfo->BUSY_CHANNEL_LOCK             = record.BusyLock;
+        pVfo->TX_LOCK                       = record.TxLock;
+        pVfo->DTMF_PTT_ID_TX_MODE           = record.PttId;
+
+        if (record.Frequency == 0xFFFFFFFF)
             pVfo->freq_config_RX.Frequency = frequencyBandTable[band].lower;
         else
-            pVfo->freq_config_RX.Frequency = info.Frequency;
-
-        if (info.Offset >= _1GHz_in_KHz)
-            info.Offset = _1GHz_in_KHz / 100;
+            pVfo->freq_config_RX.Frequency = record.Frequency;
 
-        pVfo->TX_OFFSET_FREQUENCY = info.Offset;
-
-        // ***************
+        pVfo->TX_OFFSET_FREQUENCY = record.Offset;
     }
 
     uint32_t frequency = pVfo->freq_config_RX.Frequency;
@@ -403,6 +290,25 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
     RADIO_ConfigureSquelchAndOutputPower(pVfo);
 }
 
+// Move a frequency mode VFO to the band of Frequency before tuning it
+// there, reloading the settings stored for that band.
+void RADIO_SelectBand(const unsigned int VFO, uint32_t Frequency)
+{
+    VFO_Info_t            *pVfo = &gEeprom.VfoInfo[VFO];
+    const FREQUENCY_Band_t band = FREQUENCY_GetBand(Frequency);
+
+    if (pVfo->Band == band)
+        return;
+
+    pVfo->Band                 = band;
+    gEeprom.ScreenChannel[VFO] = band + FREQ_CHANNEL_FIRST;
+    gEeprom.FreqChannel[VFO]   = band + FREQ_CHANNEL_FIRST;
+
+    SETTINGS_SaveVfoIndices();
+
+    RADIO_ConfigureChannel(VFO, VFO_CONFIGURE_RELOAD);
+}
+
 void RADIO_ConfigureSquelchAndOutputPower(VFO_Info_t *pInfo)
 {
 
@@ -907,7 +813,14 @@ void RADIO_PrepareTX(void)
     } else if (SerialConfigInProgress()) {
         // TX is disabled or config upload/download in progress
         State = VFO_STATE_TX_DISABLE;
-    } else if (gCurrentVfo->BUSY_CHANNEL_LOCK && gCurrentFunction == FUNCTION_RECEIVE) {
+    }
+#ifdef ENABLE_UART
+    else if (UART_IsKeyInjected()) {
+        // a key pressed over the cable, whatever action it is mapped to
+        State = VFO_STATE_TX_DISABLE;
+    }
+#endif
+    else if (gCurrentVfo->BUSY_CHANNEL_LOCK && gCurrentFunction == FUNCTION_RECEIVE) {
         // busy RX'ing a station
         State = VFO_STATE_BUSY;
     } else if (gBatteryDisplayLevel == 0) {
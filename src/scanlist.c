@@ -0,0 +1,79 @@
+#include "frequencies.h"
+#include "misc.h"
+#include "scanlist.h"
+#include "settings.h"
+
+ChannelSet_t gMR_ScanList[SCAN_LIST_COUNT];
+ChannelSet_t gMR_ChannelValid;
+ChannelSet_t gMR_ChannelExclude;
+
+void SCANLIST_Reset(void)
+{
+    for (unsigned int i = 0; i < SCAN_LIST_COUNT; i++)
+        CHANNELSET_Clear(&gMR_ScanList[i]);
+    CHANNELSET_Clear(&gMR_ChannelValid);
+    CHANNELSET_Clear(&gMR_ChannelExclude);
+}
+
+void SCANLIST_UpdateChannel(uint8_t Channel, ChannelAttributes_t Att)
+{
+    CHANNELSET_Assign(&gMR_ChannelValid, Channel, Att.band <= BAND7_470MHz);
+    CHANNELSET_Assign(&gMR_ScanList[0], Channel, Att.scanlist1);
+    CHANNELSET_Assign(&gMR_ScanList[1], Channel, Att.scanlist2);
+    CHANNELSET_Assign(&gMR_ScanList[2], Channel, Att.scanlist3);
+}
+
+// ScanList 1..3 - that scan list, 0 - channels in no scan list,
+// 4 - channels in any scan list, 5 - all channels
+bool SCANLIST_IsMember(uint8_t Channel, uint8_t ScanList)
+{
+    bool inAny = false;
+    for (unsigned int i = 0; i < SCAN_LIST_COUNT; i++)
+        inAny |= CHANNELSET_Contains(&gMR_ScanList[i], Channel);
+
+    if (ScanList == 0)
+        return !inAny;
+    if (ScanList <= SCAN_LIST_COUNT)
+        return CHANNELSET_Contains(&gMR_ScanList[ScanList - 1], Channel);
+    if (ScanList == SCAN_LIST_COUNT + 1)
+        return inAny;
+    return true;
+}
+
+// the channels a memory scan of ScanList visits
+void SCANLIST_GetMembers(ChannelSet_t *pSet, uint8_t ScanList)
+{
+    if (ScanList >= 1 && ScanList <= SCAN_LIST_COUNT) {
+        *pSet = gMR_ScanList[ScanList - 1];
+    }
+    else {
+        ChannelSet_t any;
+        CHANNELSET_Clear(&any);
+        for (unsigned int i = 0; i < SCAN_LIST_COUNT; i++)
+            CHANNELSET_Union(&any, &gMR_ScanList[i]);
+
+        *pSet = gMR_ChannelValid;
+        if (ScanList == 0)
+            CHANNELSET_Subtract(pSet, &any);
+        else if (ScanList == SCAN_LIST_COUNT + 1)
+            CHANNELSET_Intersect(pSet, &any);
+    }
+
+    CHANNELSET_Intersect(pSet, &gMR_ChannelValid);
+    CHANNELSET_Subtract(pSet, &gMR_ChannelExclude);
+
+    // the priority channels are visited separately by the scanner
+    if (ScanList >= 1 && ScanList <= SCAN_LIST_COUNT) {
+        CHANNELSET_Assign(pSet, gEeprom.SCANLIST_PRIORITY_CH1[ScanList - 1], false);
+        CHANNELSET_Assign(pSet, gEeprom.SCANLIST_PRIORITY_CH2[ScanList - 1], false);
+    }
+}
+
+// returns the member of the active scan list that follows Channel in the
+// given direction (wrapping around), or 0xFF if the scan list is empty
+uint8_t SCANLIST_NextChannel(uint8_t Channel, int8_t Direction)
+{
+    ChannelSet_t members;
+    SCANLIST_GetMembers(&members, gEeprom.SCAN_LIST_DEFAULT);
+    return CHANNELSET_Next(&members, Channel, Direction);
+}
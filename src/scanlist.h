@@ -0,0 +1,26 @@
+#ifndef SCANLIST_H
+#define SCANLIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "channelset.h"
+#include "misc.h"
+
+// number of scan lists stored in the channel attributes
+#define SCAN_LIST_COUNT 3
+
+// scan list membership of the memory channels
+extern ChannelSet_t gMR_ScanList[SCAN_LIST_COUNT];
+// channels holding a valid record
+extern ChannelSet_t gMR_ChannelValid;
+// channels temporarily removed from scanning (long press MENU while scanning)
+extern ChannelSet_t gMR_ChannelExclude;
+
+void    SCANLIST_Reset(void);
+void    SCANLIST_UpdateChannel(uint8_t Channel, ChannelAttributes_t Att);
+bool    SCANLIST_IsMember(uint8_t Channel, uint8_t ScanList);
+void    SCANLIST_GetMembers(ChannelSet_t *pSet, uint8_t ScanList);
+uint8_t SCANLIST_NextChannel(uint8_t Channel, int8_t Direction);
+
+#endif
@@ -0,0 +1,227 @@
+#ifdef ENABLE_SCAN_LOG
+
+#include "driver/bk4819.h"
+#include "driver/eeprom.h"
+#include "misc.h"
+#include "radio.h"
+#include "scanlog.h"
+#include "settings.h"
+
+#define SCANLOG_ENTRY_SIZE      16
+
+#ifdef ENABLE_SCAN_LOG_EEPROM
+// the last 1 KiB of the EEPROM, in the spare tail of the last bank after
+// its channel names, so only there with two banks or more
+#define SCANLOG_EEPROM_SIZE     0x0400
+#define SCANLOG_EEPROM_ENTRIES  (SCANLOG_EEPROM_SIZE / SCANLOG_ENTRY_SIZE)
+#endif
+
+// frequency of an entry on a blank EEPROM
+#define FREQUENCY_BLANK         0xFFFFFFFF
+
+_Static_assert(sizeof(SCANLOG_Entry_t) == SCANLOG_ENTRY_SIZE, "scan log entry size");
+
+static SCANLOG_Entry_t gRing[SCANLOG_RAM_ENTRIES];
+static uint8_t         gRamCount;
+// number the next closed hit gets, and how many before it can be read
+static uint16_t        gNext;
+static uint8_t         gCount;
+static uint16_t        gBootFirst;
+
+static SCANLOG_Entry_t gHit;
+static bool            gOpen;
+
+#ifdef ENABLE_SCAN_LOG_EEPROM
+static uint16_t        gEepromBase;     // 0 when not persisted
+
+static bool IsValid(const SCANLOG_Entry_t *pEntry)
+{
+    return pEntry->Frequency != FREQUENCY_BLANK && (pEntry->Source & 0x0F) <= SCANLOG_SPECTRUM;
+}
+#endif
+
+// Pick up the hits persisted before this boot. They are numbered below
+// 0x100 + the low byte of the newest, so that the next hit follows it.
+void SCANLOG_Init(void)
+{
+    gNext      = 0;
+    gBootFirst = 0;
+    gRamCount  = 0;
+    gCount     = 0;
+    gOpen      = false;
+
+#ifdef ENABLE_SCAN_LOG_EEPROM
+    SCANLOG_Entry_t entry;
+    uint8_t         sequence[SCANLOG_EEPROM_ENTRIES];
+    bool            valid[SCANLOG_EEPROM_ENTRIES];
+    uint8_t         newest;
+
+    gEepromBase = 0;
+    if (gEepromSize <= CHANNEL_BANK_SIZE)
+        return;
+
+    gEepromBase = gEepromSize - SCANLOG_EEPROM_SIZE;
+
+    EEPROM_StreamBegin(gEepromBase, SCANLOG_EEPROM_SIZE);
+    for (uint8_t i = 0; i < SCANLOG_EEPROM_ENTRIES; i++) {
+        EEPROM_StreamRead(&entry, sizeof(entry));
+        valid[i]    = IsValid(&entry);
+        sequence[i] = entry.Sequence;
+    }
+
+    // hits are written in ring order with consecutive numbers: the
+    // newest is the one its successor does not follow
+    for (newest = 0; newest < SCANLOG_EEPROM_ENTRIES; newest++) {
+        const uint8_t next = (newest + 1) % SCANLOG_EEPROM_ENTRIES;
+        if (valid[newest] &&
+            (!valid[next] || sequence[next] != (uint8_t)(sequence[newest] + 1)))
+            break;
+    }
+    if (newest == SCANLOG_EEPROM_ENTRIES)
+        return;
+
+    // and the unbroken run before it is what can be read back
+    uint8_t pos = newest;
+    gCount = 1;
+    while (gCount < SCANLOG_EEPROM_ENTRIES) {
+        const uint8_t prev = (pos + SCANLOG_EEPROM_ENTRIES - 1) % SCANLOG_EEPROM_ENTRIES;
+        if (!valid[prev] || sequence[prev] != (uint8_t)(sequence[pos] - 1))
+            break;
+        pos = prev;
+        gCount++;
+    }
+
+    gNext      = 0x100 + sequence[newest] + 1;
+    gBootFirst = gNext;
+#endif
+}
+
+// Start logging a hit, closing the previous one unless it is this one
+// again (the scanner reports a hit each time the squelch opens on it).
+void SCANLOG_Open(SCANLOG_Source_t Source, uint8_t Channel, uint32_t Frequency, uint16_t Rssi)
+{
+    if (gOpen) {
+        if ((gHit.Source & 0x0F) == Source && gHit.Channel == Channel && gHit.Frequency == Frequency) {
+            if (Rssi > gHit.Rssi)
+                gHit.Rssi = Rssi;
+            return;
+        }
+        SCANLOG_Close();
+    }
+
+    gHit.Tick_10ms   = gGlobalSysTickCounter;
+    gHit.Frequency   = Frequency;
+    gHit.Rssi        = Rssi;
+    gHit.Dwell_100ms = 0;
+    gHit.Channel     = Channel;
+    gHit.Source      = Source;
+    gHit.Code        = 0;
+    gOpen            = true;
+}
+
+// The radio has moved on: number the hit and keep it.
+void SCANLOG_Close(void)
+{
+    if (!gOpen)
+        return;
+
+    gOpen = false;
+
+    const uint32_t dwell = (gGlobalSysTickCounter - gHit.Tick_10ms) / 10;
+
+    gHit.Dwell_100ms = (dwell < 0xFFFF) ? dwell : 0xFFFF;
+    gHit.Sequence    = gNext;
+
+    gRing[gNext % SCANLOG_RAM_ENTRIES] = gHit;
+    if (gRamCount < SCANLOG_RAM_ENTRIES)
+        gRamCount++;
+
+    uint8_t max = SCANLOG_RAM_ENTRIES;
+
+#ifdef ENABLE_SCAN_LOG_EEPROM
+    if (gEepromBase != 0) {
+        const uint16_t address = gEepromBase + (gNext % SCANLOG_EEPROM_ENTRIES) * SCANLOG_ENTRY_SIZE;
+
+        // The page buffer flushes in no particular order, but hits must
+        // reach the chip in ring order: one lost in a power cut would
+        // leave the hit before it to be taken for the newest at boot.
+        // Flush before starting on another page of the ring.
+        if (address % EEPROM_PAGE_SIZE == 0 && EEPROM_IsDirty())
+            EEPROM_Flush();
+
+        // both halves share a page: one page write once flushed
+        EEPROM_WriteBuffer(address + 0, (const uint8_t *)&gHit + 0);
+        EEPROM_WriteBuffer(address + 8, (const uint8_t *)&gHit + 8);
+        max = SCANLOG_EEPROM_ENTRIES;
+    }
+#endif
+
+    if (gCount < max)
+        gCount++;
+    gNext++;
+}
+
+// Follow the open hit: its peak RSSI and, on the scanner, the code the
+// receiver matched. The BK4819 only tells whether the configured tone or
+// code is present, so that is what gets logged, not an arbitrary one.
+void SCANLOG_TimeSlice10ms(void)
+{
+    if (!gOpen)
+        return;
+
+    const uint16_t rssi = BK4819_GetRSSI();
+    if (rssi > gHit.Rssi)
+        gHit.Rssi = rssi;
+
+    if ((gHit.Source & 0x0F) != SCANLOG_SCANNER)
+        return;
+
+    if ((gCurrentCodeType == CODE_TYPE_CONTINUOUS_TONE && gFoundCTCSS) ||
+        ((gCurrentCodeType == CODE_TYPE_DIGITAL || gCurrentCodeType == CODE_TYPE_REVERSE_DIGITAL) && gFoundCDCSS))
+    {
+        gHit.Source = SCANLOG_SCANNER | (gCurrentCodeType << 4);
+        gHit.Code   = gRxVfo->pRX->Code;
+    }
+}
+
+// Copy out hit Number, false when it is gone or not there yet.
+bool SCANLOG_Read(uint16_t Number, SCANLOG_Entry_t *pEntry)
+{
+    const uint16_t age = gNext - Number;
+
+    if (age == 0 || age > gCount)
+        return false;
+
+    if (age <= gRamCount) {
+        *pEntry = gRing[Number % SCANLOG_RAM_ENTRIES];
+        return true;
+    }
+
+#ifdef ENABLE_SCAN_LOG_EEPROM
+    if (gEepromBase != 0) {
+        EEPROM_ReadBuffer(gEepromBase + (Number % SCANLOG_EEPROM_ENTRIES) * SCANLOG_ENTRY_SIZE, pEntry, sizeof(*pEntry));
+        return pEntry->Sequence == (uint8_t)Number && IsValid(pEntry);
+    }
+#endif
+
+    return false;
+}
+
+// oldest hit that can be read
+uint16_t SCANLOG_First(void)
+{
+    return gNext - gCount;
+}
+
+uint16_t SCANLOG_Next(void)
+{
+    return gNext;
+}
+
+// first hit of this boot, older ones have their ticks from another one
+uint16_t SCANLOG_BootFirst(void)
+{
+    return gBootFirst;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SCANLOG_H
+#define SCANLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Log of what the scanner and the spectrum stopped on, for unattended
+// scanning. A hit is opened when the scanner finds a signal or the
+// spectrum trigger fires, follows the peak RSSI and the CTCSS/DCS code
+// heard while it stays there, and is closed with its dwell time when the
+// radio moves on. Closed hits are numbered and kept in a RAM ring; with
+// ENABLE_SCAN_LOG_EEPROM and an EEPROM of two banks or more they also go
+// to a ring in the spare last 1 KiB, which survives a power cycle.
+// utils/scan_log.py fetches them over the UART.
+
+// most closed hits kept in RAM, a power of two
+#define SCANLOG_RAM_ENTRIES     16
+
+typedef enum {
+    SCANLOG_SCANNER = 0,
+    SCANLOG_SPECTRUM,
+} SCANLOG_Source_t;
+
+typedef struct {
+    uint32_t Tick_10ms;     // gGlobalSysTickCounter when the hit was opened
+    uint32_t Frequency;     // 10 Hz
+    uint16_t Rssi;          // peak, BK4819_GetRSSI() units
+    uint16_t Dwell_100ms;   // saturates
+    uint8_t  Sequence;      // low byte of the hit number
+    uint8_t  Channel;       // memory channel, 0xFF on a frequency
+    uint8_t  Source;        // SCANLOG_Source_t, CodeType << 4
+    uint8_t  Code;          // CTCSS/DCS code index of CodeType
+} SCANLOG_Entry_t;
+
+#ifdef ENABLE_SCAN_LOG
+
+#ifndef ENABLE_UART
+    #error "ENABLE_SCAN_LOG needs ENABLE_UART"
+#endif
+
+void     SCANLOG_Init(void);
+void     SCANLOG_Open(SCANLOG_Source_t Source, uint8_t Channel, uint32_t Frequency, uint16_t Rssi);
+void     SCANLOG_Close(void);
+void     SCANLOG_TimeSlice10ms(void);
+bool     SCANLOG_Read(uint16_t Number, SCANLOG_Entry_t *pEntry);
+uint16_t SCANLOG_First(void);
+uint16_t SCANLOG_Next(void);
+uint16_t SCANLOG_BootFirst(void);
+
+#endif
+
+#endif
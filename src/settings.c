@@ -20,10 +20,14 @@
 #ifdef ENABLE_FMRADIO
     #include "app/fm.h"
 #endif
+#include "chcache.h"
 #include "driver/bk1080.h"
 #include "driver/bk4819.h"
+#include "driver/crc.h"
 #include "driver/eeprom.h"
+#include "journal.h"
 #include "misc.h"
+#include "scanlist.h"
 #include "settings.h"
 #include "ui/menu.h"
 
@@ -38,11 +42,136 @@ static const uint32_t gDefaultFrequencyTable[] =
 
 EEPROM_Config_t gEeprom = { 0 };
 
+SETTINGS_LoadStatus_t gSettingsLoadStatus;
+
+// EEPROM address of each 8 byte block written by SETTINGS_SaveSettings()
+static const uint16_t gSettingsBlockAddress[] = {
+    0x0E70, 0x0E78, 0x0E90, 0x0EA0, 0x0EA8, 0x0ED0, 0x0ED8, 0x0F18, 0x0F40, 0x1FF0
+};
+
+#define SETTINGS_BLOCK_COUNT ARRAY_SIZE(gSettingsBlockAddress)
+
+// what each block held when it was last loaded or committed
+static uint8_t gSettingsCommitted[SETTINGS_BLOCK_COUNT][8];
+// idle time left before a requested save is committed, 0 if none pending
+static uint8_t gSettingsCommitCountdown_500ms;
+
+// Layout header and per block CRC of the blocks above, in a page of its
+// own. Bump the version whenever the meaning of a block changes and teach
+// CheckSettings() how to get there from the previous one.
+#define SETTINGS_SEAL_ADDRESS   0x1FA0
+#define SETTINGS_SEAL_MAGIC     0x5E77
+#define SETTINGS_LAYOUT_VERSION 2
+
+typedef struct {
+    uint16_t Magic;
+    uint8_t  Version;
+    uint8_t  Count;
+    uint8_t  Unused[4];
+    uint16_t Crc[12];
+} __attribute__((packed)) SettingsSeal_t;
+
+_Static_assert(sizeof(SettingsSeal_t) == 32, "settings seal size");
+_Static_assert(SETTINGS_BLOCK_COUNT <= 12, "settings seal too small");
+
+static void ResetCommittedSettings(void);
+static void SealSettings(const uint8_t Blocks[][8]);
+
+static void ApplyChannelAttributes(void)
+{
+    SCANLIST_Reset();
+    for(uint16_t i = 0; i < sizeof(gMR_ChannelAttributes); i++) {
+        ChannelAttributes_t *att = &gMR_ChannelAttributes[i];
+        if(att->__val == 0xff){
+            att->__val = 0;
+            att->band = 0x7;
+        }
+        SCANLIST_UpdateChannel(i, *att);
+    }
+}
+
+// settings area read at boot, decoded from RAM
+#define SETTINGS_AREA_START 0x0E40
+#define SETTINGS_AREA_END   0x0F50
+#define SETTINGS_BLOCK(a)   (Settings + ((a) - SETTINGS_AREA_START))
+
+// Check the blocks just read against the seal. A block failing its CRC is
+// replaced with erased bytes so it decodes to defaults as a whole, rather
+// than as a mix of stored and default fields. Returns false when the
+// blocks must be rewritten and resealed.
+static bool CheckSettings(uint8_t *pSettings, uint8_t *pExtra, const SettingsSeal_t *pSeal)
+{
+    bool ok = true;
+
+    if (pSeal->Magic != SETTINGS_SEAL_MAGIC) {
+        // layout from before the seal existed: same blocks, no CRCs, the
+        // field range checks are all there is to go by
+        gSettingsLoadStatus = SETTINGS_LOAD_MIGRATED;
+        return false;
+    }
+
+    switch (pSeal->Version) {
+        case 1:
+            // 0x0EA3 (channel bank) was padding, always 0xFF, which the
+            // range check turns into bank 0: nothing to convert, but the
+            // seal has to be rewritten with the new version
+            gSettingsLoadStatus = SETTINGS_LOAD_MIGRATED;
+            return false;
+
+        case SETTINGS_LAYOUT_VERSION:
+            break;
+
+        default:
+            // written by some other firmware, keep what passes the range
+            // checks and reseal in our layout
+            gSettingsLoadStatus = SETTINGS_LOAD_MIGRATED;
+            return false;
+    }
+
+    if (pSeal->Count != SETTINGS_BLOCK_COUNT) {
+        gSettingsLoadStatus = SETTINGS_LOAD_MIGRATED;
+        return false;
+    }
+
+    for (unsigned int i = 0; i < SETTINGS_BLOCK_COUNT; i++) {
+        const uint16_t address = gSettingsBlockAddress[i];
+        uint8_t       *pBlock  = (address >= SETTINGS_AREA_END) ? pExtra : pSettings + (address - SETTINGS_AREA_START);
+
+        if (CRC_Calculate(pBlock, 8) != pSeal->Crc[i]) {
+            memset(pBlock, 0xFF, 8);
+            gSettingsLoadStatus = SETTINGS_LOAD_REPAIRED;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
 void SETTINGS_InitEEPROM(void)
 {
-    uint8_t Data[16] = {0};
+    uint8_t        Settings[SETTINGS_AREA_END - SETTINGS_AREA_START];
+    const uint8_t *Data;
+
+    // 0D60..0F4F in a single transaction: the channel attributes straight
+    // into place, the settings blocks into the scratch buffer
+    EEPROM_StreamBegin(0x0D60, SETTINGS_AREA_END - 0x0D60);
+    EEPROM_StreamRead(gMR_ChannelAttributes, sizeof(gMR_ChannelAttributes));
+    EEPROM_StreamSkip(SETTINGS_AREA_START - 0x0D60 - sizeof(gMR_ChannelAttributes));
+    EEPROM_StreamRead(Settings, sizeof(Settings));
+
+    // 1FA0..1FBF and 1FF0..1FF7, again in one go
+    SettingsSeal_t Seal;
+    uint8_t        Extra[8];
+    EEPROM_StreamBegin(SETTINGS_SEAL_ADDRESS, 0x1FF8 - SETTINGS_SEAL_ADDRESS);
+    EEPROM_StreamRead(&Seal, sizeof(Seal));
+    EEPROM_StreamSkip(0x1FF0 - SETTINGS_SEAL_ADDRESS - sizeof(Seal));
+    EEPROM_StreamRead(Extra, sizeof(Extra));
+
+    gSettingsLoadStatus = SETTINGS_LOAD_OK;
+    const bool sealed = CheckSettings(Settings, Extra, &Seal);
+
     // 0E70..0E77
-    EEPROM_ReadBuffer(0x0E70, Data, 8);
+    Data = SETTINGS_BLOCK(0x0E70);
     gEeprom.CHAN_1_CALL          = IS_MR_CHANNEL(Data[0]) ? Data[0] : MR_CHANNEL_FIRST;
     gEeprom.SQUELCH_LEVEL        = (Data[1] < 10) ? Data[1] : 1;
     gEeprom.TX_TIMEOUT_TIMER     = (Data[2] > 4 && Data[2] < 180) ? Data[2] : 11;
@@ -50,7 +179,7 @@ void SETTINGS_InitEEPROM(void)
     gEeprom.MIC_SENSITIVITY      = (Data[7] <  5) ? Data[7] : 4;
 
     // 0E78..0E7F
-    EEPROM_ReadBuffer(0x0E78, Data, 8);
+    Data = SETTINGS_BLOCK(0x0E78);
     gEeprom.BACKLIGHT_MAX         = (Data[0] & 0xF) <= 10 ? (Data[0] & 0xF) : 10;
     gEeprom.BACKLIGHT_MIN         = (Data[0] >> 4) < gEeprom.BACKLIGHT_MAX ? (Data[0] >> 4) : 0;
 #ifdef ENABLE_BLMIN_TMP_OFF
@@ -64,8 +193,9 @@ void SETTINGS_InitEEPROM(void)
     gEeprom.TAIL_TONE_ELIMINATION = (Data[6] < 2) ? Data[6] : false;
     gEeprom.VFO_OPEN              = (Data[7] < 2) ? Data[7] : true;
 
-    // 0E80..0E87
-    EEPROM_ReadBuffer(0x0E80, Data, 8);
+    // 0E80..0E87, superseded by the journal
+    JOURNAL_Init(SETTINGS_BLOCK(0x0E80));
+    Data = SETTINGS_BLOCK(0x0E80);
     gEeprom.ScreenChannel[0]   = IS_VALID_CHANNEL(Data[0]) ? Data[0] : (FREQ_CHANNEL_FIRST + BAND6_400MHz);
     gEeprom.ScreenChannel[1]   = IS_VALID_CHANNEL(Data[3]) ? Data[3] : (FREQ_CHANNEL_FIRST + BAND6_400MHz);
     gEeprom.MrChannel[0]       = IS_MR_CHANNEL(Data[1])    ? Data[1] : MR_CHANNEL_FIRST;
@@ -83,7 +213,7 @@ void SETTINGS_InitEEPROM(void)
             uint8_t  band:2;
             //uint8_t  space:2;
         } __attribute__((packed)) fmCfg;
-        EEPROM_ReadBuffer(0x0E88, &fmCfg, 4);
+        memcpy(&fmCfg, SETTINGS_BLOCK(0x0E88), 4);
 
         gEeprom.FM_Band = fmCfg.band;
         //gEeprom.FM_Space = fmCfg.space;
@@ -96,12 +226,12 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0E40..0E67
-    EEPROM_ReadBuffer(0x0E40, gFM_Channels, sizeof(gFM_Channels));
+    memcpy(gFM_Channels, SETTINGS_BLOCK(0x0E40), sizeof(gFM_Channels));
     FM_ConfigureChannelState();
 #endif
 
     // 0E90..0E97
-    EEPROM_ReadBuffer(0x0E90, Data, 8);
+    Data = SETTINGS_BLOCK(0x0E90);
     gEeprom.BEEP_CONTROL                 = Data[0] & 1;
     gEeprom.KEY_M_LONG_PRESS_ACTION      = ((Data[0] >> 1) < ACTION_OPT_LEN) ? (Data[0] >> 1) : ACTION_OPT_NONE;
     gEeprom.KEY_1_SHORT_PRESS_ACTION     = (Data[1] < ACTION_OPT_LEN) ? Data[1] : ACTION_OPT_MONITOR;
@@ -112,7 +242,7 @@ void SETTINGS_InitEEPROM(void)
     gEeprom.AUTO_KEYPAD_LOCK             = (Data[6] < 41)             ? Data[6] : 0;
     gEeprom.POWER_ON_DISPLAY_MODE        = (Data[7] < 6)              ? Data[7] : POWER_ON_DISPLAY_MODE_MESSAGE;
     // 0EA0..0EA7
-    EEPROM_ReadBuffer(0x0EA0, Data, 8);
+    Data = SETTINGS_BLOCK(0x0EA0);
     if((Data[1] < 200 && Data[1] > 90) && (Data[2] < Data[1]-9 && Data[1] < 160  && Data[2] > 50)) {
         gEeprom.S0_LEVEL = Data[1];
         gEeprom.S9_LEVEL = Data[2];
@@ -121,28 +251,29 @@ void SETTINGS_InitEEPROM(void)
         gEeprom.S0_LEVEL = 130;
         gEeprom.S9_LEVEL = 76;
     }
+    gEeprom.CHANNEL_BANK = (Data[3] < SETTINGS_ChannelBankCount()) ? Data[3] : 0;
 
     // 0EA8..0EAF
-    EEPROM_ReadBuffer(0x0EA8, Data, 8);
+    Data = SETTINGS_BLOCK(0x0EA8);
     gEeprom.ROGER                          = (Data[1] <  3) ? Data[1] : ROGER_MODE_OFF;
     gEeprom.REPEATER_TAIL_TONE_ELIMINATION = (Data[2] < 11) ? Data[2] : 0;
     gEeprom.TX_VFO                         = (Data[3] <  2) ? Data[3] : 0;
     gEeprom.BATTERY_TYPE                   = (Data[4] < BATTERY_TYPE_UNKNOWN) ? Data[4] : BATTERY_TYPE_1600_MAH;
 
     // 0ED0..0ED7
-    EEPROM_ReadBuffer(0x0ED0, Data, 8);
+    Data = SETTINGS_BLOCK(0x0ED0);
     gEeprom.DTMF_SIDE_TONE               = (Data[0] <   2) ? Data[0] : true;
     gEeprom.DTMF_PRELOAD_TIME            = (Data[5] < 101) ? Data[5] * 10 : 300;
     gEeprom.DTMF_FIRST_CODE_PERSIST_TIME = (Data[6] < 101) ? Data[6] * 10 : 100;
     gEeprom.DTMF_HASH_CODE_PERSIST_TIME  = (Data[7] < 101) ? Data[7] * 10 : 100;
 
     // 0ED8..0EDF
-    EEPROM_ReadBuffer(0x0ED8, Data, 8);
+    Data = SETTINGS_BLOCK(0x0ED8);
     gEeprom.DTMF_CODE_PERSIST_TIME  = (Data[0] < 101) ? Data[0] * 10 : 100;
     gEeprom.DTMF_CODE_INTERVAL_TIME = (Data[1] < 101) ? Data[1] * 10 : 100;
 
     // 0EF8..0F07
-    EEPROM_ReadBuffer(0x0EF8, Data, sizeof(gEeprom.DTMF_UP_CODE));
+    Data = SETTINGS_BLOCK(0x0EF8);
     if (DTMF_ValidateCodes((char *)Data, sizeof(gEeprom.DTMF_UP_CODE))) {
         memcpy(gEeprom.DTMF_UP_CODE, Data, sizeof(gEeprom.DTMF_UP_CODE));
     } else {
@@ -150,7 +281,7 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0F08..0F17
-    EEPROM_ReadBuffer(0x0F08, Data, sizeof(gEeprom.DTMF_DOWN_CODE));
+    Data = SETTINGS_BLOCK(0x0F08);
     if (DTMF_ValidateCodes((char *)Data, sizeof(gEeprom.DTMF_DOWN_CODE))) {
         memcpy(gEeprom.DTMF_DOWN_CODE, Data, sizeof(gEeprom.DTMF_DOWN_CODE));
     } else {
@@ -158,7 +289,7 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0F18..0F1F
-    EEPROM_ReadBuffer(0x0F18, Data, 8);
+    Data = SETTINGS_BLOCK(0x0F18);
     gEeprom.SCAN_LIST_DEFAULT = (Data[0] < 6) ? Data[0] : 0;  // we now have 'all' channel scan option
 
     // Fix me probably after Chirp update...
@@ -175,7 +306,7 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0F40..0F47
-    EEPROM_ReadBuffer(0x0F40, Data, 8);
+    Data = SETTINGS_BLOCK(0x0F40);
     gSetting_F_LOCK            = (Data[0] < F_LOCK_LEN) ? Data[0] : F_LOCK_DEF;
     gSetting_350EN             = (Data[5] < 2) ? Data[5] : true;
     gSetting_ScrambleEnable    = false;
@@ -193,30 +324,27 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0D60..0E27
-    EEPROM_ReadBuffer(0x0D60, gMR_ChannelAttributes, sizeof(gMR_ChannelAttributes));
-    for(uint16_t i = 0; i < sizeof(gMR_ChannelAttributes); i++) {
-        ChannelAttributes_t *att = &gMR_ChannelAttributes[i];
-        if(att->__val == 0xff){
-            att->__val = 0;
-            att->band = 0x7;
-        }
-        gMR_ChannelExclude[i] = false;
-    }
+    if (gEeprom.CHANNEL_BANK != 0)
+        EEPROM_ReadLarge(SETTINGS_ChannelBankBase() + 0x0D60, gMR_ChannelAttributes, MR_CHANNEL_LAST + 1);
+    ApplyChannelAttributes();
+
+    // 0000..0C7F, 0F50..1C3F
+    CHCACHE_Init();
 
     // 0F30..0F3F
-    EEPROM_ReadBuffer(0x0F30, gCustomAesKey, sizeof(gCustomAesKey));
+    memcpy(gCustomAesKey, SETTINGS_BLOCK(0x0F30), sizeof(gCustomAesKey));
     bHasCustomAesKey = false;
     for (unsigned int i = 0; i < ARRAY_SIZE(gCustomAesKey); i++)
     {
         if (gCustomAesKey[i] != 0xFFFFFFFFu)
         {
             bHasCustomAesKey = true;
-            return;
+            break;
         }
     }
 
     // 1FF0..0x1FF7
-    EEPROM_ReadBuffer(0x1FF0, Data, 8);
+    Data = Extra;
     gSetting_set_pwr = (((Data[7] & 0xF0) >> 4) < 7) ? ((Data[7] & 0xF0) >> 4) : 0;
     gSetting_set_ptt = (((Data[7] & 0x0F)) < 2) ? ((Data[7] & 0x0F)) : 0;
 
@@ -243,22 +371,35 @@ void SETTINGS_InitEEPROM(void)
     // And set special session settings for actions
     gSetting_set_ptt_session = gSetting_set_ptt;
     gEeprom.KEY_LOCK_PTT = gSetting_set_lck;
+
+    ResetCommittedSettings();
+
+    if (!sealed) {
+        // store what was actually loaded, in the current layout
+        for (unsigned int i = 0; i < SETTINGS_BLOCK_COUNT; i++)
+            EEPROM_WriteBuffer(gSettingsBlockAddress[i], gSettingsCommitted[i]);
+        SealSettings(gSettingsCommitted);
+    }
 }
 
 void SETTINGS_LoadCalibration(void)
 {
 //  uint8_t Mic;
 
-    EEPROM_ReadBuffer(0x1EC0, gEEPROM_RSSI_CALIB[3], 8);
+    // 1EC0..1F8F in a single transaction
+    EEPROM_StreamBegin(0x1EC0, 0x1F90 - 0x1EC0);
+
+    EEPROM_StreamRead(gEEPROM_RSSI_CALIB[3], 8);
     memcpy(gEEPROM_RSSI_CALIB[4], gEEPROM_RSSI_CALIB[3], 8);
     memcpy(gEEPROM_RSSI_CALIB[5], gEEPROM_RSSI_CALIB[3], 8);
     memcpy(gEEPROM_RSSI_CALIB[6], gEEPROM_RSSI_CALIB[3], 8);
 
-    EEPROM_ReadBuffer(0x1EC8, gEEPROM_RSSI_CALIB[0], 8);
+    EEPROM_StreamRead(gEEPROM_RSSI_CALIB[0], 8);
     memcpy(gEEPROM_RSSI_CALIB[1], gEEPROM_RSSI_CALIB[0], 8);
     memcpy(gEEPROM_RSSI_CALIB[2], gEEPROM_RSSI_CALIB[0], 8);
 
-    EEPROM_ReadBuffer(0x1F40, gBatteryCalibration, 12);
+    EEPROM_StreamSkip(0x1F40 - 0x1ED0);
+    EEPROM_StreamRead(gBatteryCalibration, 12);
     if (gBatteryCalibration[0] >= 5000)
     {
         gBatteryCalibration[0] = 1900;
@@ -280,7 +421,8 @@ void SETTINGS_LoadCalibration(void)
 
         // radio 1 .. 04 00 46 00 50 00 2C 0E
         // radio 2 .. 05 00 46 00 50 00 2C 0E
-        EEPROM_ReadBuffer(0x1F88, &Misc, 8);
+        EEPROM_StreamSkip(0x1F88 - 0x1F4C);
+        EEPROM_StreamRead(&Misc, 8);
 
         gEeprom.BK4819_XTAL_FREQ_LOW = (Misc.BK4819_XtalFreqLow >= -1000 && Misc.BK4819_XtalFreqLow <= 1000) ? Misc.BK4819_XtalFreqLow : 0;
         gEEPROM_1F8A                 = Misc.EEPROM_1F8A & 0x01FF;
@@ -293,8 +435,101 @@ void SETTINGS_LoadCalibration(void)
     }
 }
 
+static uint8_t DecodeCode(uint8_t CodeType, uint8_t Code, uint8_t *pCode)
+{
+    switch (CodeType)
+    {
+        default:
+        case CODE_TYPE_OFF:
+            *pCode = 0;
+            return CODE_TYPE_OFF;
+
+        case CODE_TYPE_CONTINUOUS_TONE:
+            *pCode = (Code < ARRAY_SIZE(CTCSS_Options)) ? Code : 0;
+            break;
+
+        case CODE_TYPE_DIGITAL:
+        case CODE_TYPE_REVERSE_DIGITAL:
+            *pCode = (Code < ARRAY_SIZE(DCS_Options)) ? Code : 0;
+            break;
+    }
+
+    return CodeType;
+}
+
+void SETTINGS_DecodeChannelRecord(const uint8_t *pData, ChannelRecord_t *pRecord)
+{
+    uint32_t offset;
+    uint8_t  tmp;
+
+    memcpy(&pRecord->Frequency, pData + 0, sizeof(pRecord->Frequency));
+
+    memcpy(&offset, pData + 4, sizeof(offset));
+    if (offset >= _1GHz_in_KHz)
+        offset = _1GHz_in_KHz / 100;
+    pRecord->Offset = offset;
+
+    pRecord->RxCodeType = DecodeCode((pData[10] >> 0) & 0x0F, pData[8], &pRecord->RxCode);
+    pRecord->TxCodeType = DecodeCode((pData[10] >> 4) & 0x0F, pData[9], &pRecord->TxCode);
+
+    tmp = pData[11] & 0x0F;
+    pRecord->OffsetDir  = (tmp > TX_OFFSET_FREQUENCY_DIRECTION_SUB) ? TX_OFFSET_FREQUENCY_DIRECTION_OFF : tmp;
+    tmp = pData[11] >> 4;
+    pRecord->Modulation = (tmp >= MODULATION_UKNOWN) ? MODULATION_FM : tmp;
+
+    if (pData[12] == 0xFF)
+    {
+        pRecord->Reverse   = false;
+        pRecord->Bandwidth = BK4819_FILTER_BW_WIDE;
+        pRecord->Power     = OUTPUT_POWER_LOW1;
+        pRecord->BusyLock  = false;
+        pRecord->TxLock    = true;
+    }
+    else
+    {
+        const uint8_t d4 = pData[12];
+        pRecord->Reverse   = !!((d4 >> 0) & 1u);
+        pRecord->Bandwidth = !!((d4 >> 1) & 1u);
+        pRecord->Power     =   ((d4 >> 2) & 7u);
+        pRecord->BusyLock  = !!((d4 >> 5) & 1u);
+        pRecord->TxLock    = !!((d4 >> 6) & 1u);
+    }
+
+    tmp = (pData[13] >> 1) & 7u;
+    pRecord->PttId = (pData[13] != 0xFF && tmp < ARRAY_SIZE(gSubMenu_PTT_ID)) ? tmp : PTT_ID_OFF;
+
+    tmp = pData[14];
+    pRecord->Step = (tmp < STEP_N_ELEM) ? tmp : STEP_12_5kHz;
+}
+
+// s must have room for 11 chars
+void SETTINGS_DecodeChannelName(char *s, const uint8_t *pData)
+{
+    int i;
+    for (i = 0; i < 10; i++) {
+        if (pData[i] < 32 || pData[i] > 127)
+            break;                // invalid char
+        s[i] = pData[i];
+    }
+
+    s[i--] = 0;                   // null term
+
+    while (i >= 0 && s[i] == 32)  // trim trailing spaces
+        s[i--] = 0;               // null term
+}
+
+void SETTINGS_FetchChannelRecord(uint16_t Address, ChannelRecord_t *pRecord)
+{
+    uint8_t data[16];
+    EEPROM_ReadBuffer(Address, data, sizeof(data));
+    SETTINGS_DecodeChannelRecord(data, pRecord);
+}
+
 uint32_t SETTINGS_FetchChannelFrequency(const int channel)
 {
+    if (channel >= 0 && IS_MR_CHANNEL(channel))
+        return CHCACHE_GetFrequency(channel);
+
     struct
     {
         uint32_t frequency;
@@ -319,17 +554,7 @@ void SETTINGS_FetchChannelName(char *s, const int channel)
     if (!RADIO_CheckValidChannel(channel, false, 0))
         return;
 
-    EEPROM_ReadBuffer(0x0F50 + (channel * 16), s, 10);
-
-    int i;
-    for (i = 0; i < 10; i++)
-        if (s[i] < 32 || s[i] > 127)
-            break;                // invalid char
-
-    s[i--] = 0;                   // null term
-
-    while (i >= 0 && s[i] == 32)  // trim trailing spaces
-        s[i--] = 0;               // null term
+    CHCACHE_FetchName(s, channel);
 }
 
 void SETTINGS_FactoryReset(bool bIsAll)
@@ -337,6 +562,13 @@ void SETTINGS_FactoryReset(bool bIsAll)
     uint16_t i;
     uint8_t  Template[8];
 
+    // the default channels go to the classic bank
+    if (bIsAll)
+        SETTINGS_SelectChannelBank(0);
+
+    // a save still pending must not land on top of the reset
+    SETTINGS_CommitSettings();
+
     memset(Template, 0xFF, sizeof(Template));
 
     //for (i = 0x0C80; i < 0x1E00; i += 8)
@@ -378,6 +610,9 @@ void SETTINGS_FactoryReset(bool bIsAll)
 
         EEPROM_WriteBuffer(0x1FF0, Template);
     }
+
+    JOURNAL_Reset();
+    SETTINGS_SealSettings();
 }
 
 #ifdef ENABLE_FMRADIO
@@ -409,18 +644,16 @@ void SETTINGS_SaveFM(void)
 
 void SETTINGS_SaveVfoIndices(void)
 {
-    uint8_t State[8];
+    JOURNAL_SaveIndices();
+}
 
-    State[0] = gEeprom.ScreenChannel[0];
-    State[1] = gEeprom.MrChannel[0];
-    State[2] = gEeprom.FreqChannel[0];
-    State[3] = gEeprom.ScreenChannel[1];
-    State[4] = gEeprom.MrChannel[1];
-    State[5] = gEeprom.FreqChannel[1];
-    EEPROM_WriteBuffer(0x0E80, State);
+// only the RX frequency of a VFO changed (e.g. a frequency scan stopped)
+void SETTINGS_SaveVfoFrequency(uint8_t VFO, const VFO_Info_t *pVFO)
+{
+    JOURNAL_SaveFrequency(pVFO->CHANNEL_SAVE, VFO, pVFO->freq_config_RX.Frequency);
 }
 
-void SETTINGS_SaveSettings(void)
+static void EncodeSettings(uint8_t Blocks[][8])
 {
     uint8_t  State[8];
     uint8_t tmp = 0;
@@ -433,7 +666,7 @@ void SETTINGS_SaveSettings(void)
     State[5] = false;
     State[6] = 0;
     State[7] = gEeprom.MIC_SENSITIVITY;
-    EEPROM_WriteBuffer(0x0E70, State);
+    memcpy(Blocks[0], State, 8);
 
     State[0] = (gEeprom.BACKLIGHT_MIN << 4) + gEeprom.BACKLIGHT_MAX;
     State[1] = gEeprom.CHANNEL_DISPLAY_MODE;
@@ -457,7 +690,7 @@ void SETTINGS_SaveSettings(void)
 
     State[6] = gEeprom.TAIL_TONE_ELIMINATION;
     State[7] = gEeprom.VFO_OPEN;
-    EEPROM_WriteBuffer(0x0E78, State);
+    memcpy(Blocks[1], State, 8);
 
     State[0] = gEeprom.BEEP_CONTROL;
     State[0] |= gEeprom.KEY_M_LONG_PRESS_ACTION << 1;
@@ -468,12 +701,13 @@ void SETTINGS_SaveSettings(void)
     State[5] = gEeprom.SCAN_RESUME_MODE;
     State[6] = gEeprom.AUTO_KEYPAD_LOCK;
     State[7] = gEeprom.POWER_ON_DISPLAY_MODE;
-    EEPROM_WriteBuffer(0x0E90, State);
+    memcpy(Blocks[2], State, 8);
 
     memset(State, 0xFF, sizeof(State));
     State[1] = gEeprom.S0_LEVEL;
     State[2] = gEeprom.S9_LEVEL;
-    EEPROM_WriteBuffer(0x0EA0, State);
+    State[3] = gEeprom.CHANNEL_BANK;
+    memcpy(Blocks[3], State, 8);
     #ifdef ENABLE_TX1750
         State[0] = gEeprom.ALARM_MODE;
     #else
@@ -483,18 +717,18 @@ void SETTINGS_SaveSettings(void)
     State[2] = gEeprom.REPEATER_TAIL_TONE_ELIMINATION;
     State[3] = gEeprom.TX_VFO;
     State[4] = gEeprom.BATTERY_TYPE;
-    EEPROM_WriteBuffer(0x0EA8, State);
+    memcpy(Blocks[4], State, 8);
 
     State[0] = gEeprom.DTMF_SIDE_TONE;
     State[5] = gEeprom.DTMF_PRELOAD_TIME / 10U;
     State[6] = gEeprom.DTMF_FIRST_CODE_PERSIST_TIME / 10U;
     State[7] = gEeprom.DTMF_HASH_CODE_PERSIST_TIME / 10U;
-    EEPROM_WriteBuffer(0x0ED0, State);
+    memcpy(Blocks[5], State, 8);
 
     memset(State, 0xFF, sizeof(State));
     State[0] = gEeprom.DTMF_CODE_PERSIST_TIME / 10U;
     State[1] = gEeprom.DTMF_CODE_INTERVAL_TIME / 10U;
-    EEPROM_WriteBuffer(0x0ED8, State);
+    memcpy(Blocks[6], State, 8);
 
     State[0] = gEeprom.SCAN_LIST_DEFAULT;
 
@@ -514,7 +748,7 @@ void SETTINGS_SaveSettings(void)
     State[5] = gEeprom.SCANLIST_PRIORITY_CH2[1];
     State[6] = gEeprom.SCANLIST_PRIORITY_CH1[2];
     State[7] = gEeprom.SCANLIST_PRIORITY_CH2[2];
-    EEPROM_WriteBuffer(0x0F18, State);
+    memcpy(Blocks[7], State, 8);
 
     memset(State, 0xFF, sizeof(State));
     State[0]  = gSetting_F_LOCK;
@@ -531,7 +765,7 @@ void SETTINGS_SaveSettings(void)
 
     State[7] = (State[7] & ~(3u << 6)) | ((gSetting_backlight_on_tx_rx & 3u) << 6);
 
-    EEPROM_WriteBuffer(0x0F40, State);
+    memcpy(Blocks[8], State, 8);
 
     EEPROM_ReadBuffer(0x1FF0, State, sizeof(State));
 
@@ -548,12 +782,93 @@ void SETTINGS_SaveSettings(void)
 
     gEeprom.KEY_LOCK_PTT = gSetting_set_lck;
 
-    EEPROM_WriteBuffer(0x1FF0, State);
+    memcpy(Blocks[9], State, 8);
+}
+
+// the settings were just (re)loaded from EEPROM, nothing is pending
+static void ResetCommittedSettings(void)
+{
+    gSettingsCommitCountdown_500ms = 0;
+    EncodeSettings(gSettingsCommitted);
+}
+
+// Re-encode the settings and write the blocks that changed since the last
+// commit (usually one or two after a menu change).
+void SETTINGS_CommitSettings(void)
+{
+    uint8_t Blocks[SETTINGS_BLOCK_COUNT][8];
+
+    gSettingsCommitCountdown_500ms = 0;
+
+    EncodeSettings(Blocks);
+
+    bool changed = false;
+
+    for (unsigned int i = 0; i < SETTINGS_BLOCK_COUNT; i++) {
+        if (memcmp(Blocks[i], gSettingsCommitted[i], 8) != 0) {
+            EEPROM_WriteBuffer(gSettingsBlockAddress[i], Blocks[i]);
+            memcpy(gSettingsCommitted[i], Blocks[i], 8);
+            changed = true;
+        }
+    }
+
+    if (changed)
+        SealSettings(gSettingsCommitted);
+}
+
+static void SealSettings(const uint8_t Blocks[][8])
+{
+    SettingsSeal_t Seal;
+
+    memset(&Seal, 0xFF, sizeof(Seal));
+    Seal.Magic   = SETTINGS_SEAL_MAGIC;
+    Seal.Version = SETTINGS_LAYOUT_VERSION;
+    Seal.Count   = SETTINGS_BLOCK_COUNT;
+    for (unsigned int i = 0; i < SETTINGS_BLOCK_COUNT; i++)
+        Seal.Crc[i] = CRC_Calculate(Blocks[i], 8);
+
+    for (unsigned int i = 0; i < sizeof(Seal); i += 8)
+        EEPROM_WriteBuffer(SETTINGS_SEAL_ADDRESS + i, (const uint8_t *)&Seal + i);
+}
+
+// Reseal the blocks as they are in EEPROM, after something other than
+// SETTINGS_CommitSettings() wrote to them.
+void SETTINGS_SealSettings(void)
+{
+    uint8_t Blocks[SETTINGS_BLOCK_COUNT][8];
+
+    for (unsigned int i = 0; i < SETTINGS_BLOCK_COUNT; i++)
+        EEPROM_ReadBuffer(gSettingsBlockAddress[i], Blocks[i], 8);
+
+    SealSettings(Blocks);
+}
+
+bool SETTINGS_IsSettingsBlock(uint16_t Address, uint16_t Size)
+{
+    for (unsigned int i = 0; i < SETTINGS_BLOCK_COUNT; i++)
+        if (Address < gSettingsBlockAddress[i] + 8 && (uint32_t)Address + Size > gSettingsBlockAddress[i])
+            return true;
+    return false;
+}
+
+// Settings changes are committed once the radio has been idle for a
+// second, so bursts of saves from the menu cost one write of the changed
+// blocks only.
+void SETTINGS_SaveSettings(void)
+{
+    gEeprom.KEY_LOCK_PTT = gSetting_set_lck;
+    gSettingsCommitCountdown_500ms = 2;
+}
+
+void SETTINGS_TimeSlice500ms(void)
+{
+    if (gSettingsCommitCountdown_500ms > 0 && --gSettingsCommitCountdown_500ms == 0)
+        SETTINGS_CommitSettings();
 }
 
 void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO, uint8_t Mode)
 {
-    uint16_t OffsetVFO = Channel * 16;
+    uint16_t OffsetVFO = SETTINGS_ChannelBankBase() + Channel * 16;
 
     if (IS_FREQ_CHANNEL(Channel)) { // it's a VFO, not a channel
         OffsetVFO  = (VFO == 0) ? 0x0C80 : 0x0C90;
@@ -562,29 +877,34 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
 
     if (Mode >= 2 || IS_FREQ_CHANNEL(Channel)) { // copy VFO to a channel
         union {
-            uint8_t _8[8];
-            uint32_t _32[2];
+            uint8_t _8[16];
+            uint32_t _32[4];
         } State;
 
         State._32[0] = pVFO->freq_config_RX.Frequency;
         State._32[1] = pVFO->TX_OFFSET_FREQUENCY;
-        EEPROM_WriteBuffer(OffsetVFO + 0, State._32);
+        EEPROM_WriteBuffer(OffsetVFO + 0, State._8 + 0);
 
-        State._8[0] =  pVFO->freq_config_RX.Code;
-        State._8[1] =  pVFO->freq_config_TX.Code;
-        State._8[2] = (pVFO->freq_config_TX.CodeType << 4) | pVFO->freq_config_RX.CodeType;
-        State._8[3] = (pVFO->Modulation << 4) | pVFO->TX_OFFSET_FREQUENCY_DIRECTION;
-        State._8[4] = 0
+        State._8[8]  =  pVFO->freq_config_RX.Code;
+        State._8[9]  =  pVFO->freq_config_TX.Code;
+        State._8[10] = (pVFO->freq_config_TX.CodeType << 4) | pVFO->freq_config_RX.CodeType;
+        State._8[11] = (pVFO->Modulation << 4) | pVFO->TX_OFFSET_FREQUENCY_DIRECTION;
+        State._8[12] = 0
             | (pVFO->TX_LOCK << 6)
             | (pVFO->BUSY_CHANNEL_LOCK << 5)
             | (pVFO->OUTPUT_POWER      << 2)
             | (pVFO->CHANNEL_BANDWIDTH << 1)
             | (pVFO->FrequencyReverse  << 0);
-        State._8[5] = ((pVFO->DTMF_PTT_ID_TX_MODE & 7u) << 1)
+        State._8[13] = ((pVFO->DTMF_PTT_ID_TX_MODE & 7u) << 1)
         ;
-        State._8[6] =  pVFO->STEP_SETTING;
-        State._8[7] =  0;
-        EEPROM_WriteBuffer(OffsetVFO + 8, State._8);
+        State._8[14] =  pVFO->STEP_SETTING;
+        State._8[15] =  0;
+        EEPROM_WriteBuffer(OffsetVFO + 8, State._8 + 8);
+
+        if (IS_MR_CHANNEL(Channel))
+            CHCACHE_UpdateRecord(Channel, State._8);
+        else
+            JOURNAL_Forget(Channel, VFO);
 
         SETTINGS_UpdateChannel(Channel, pVFO, true, true, true);
 
@@ -609,11 +929,12 @@ void SETTINGS_SaveBatteryCalibration(const uint16_t * batteryCalibration)
 
 void SETTINGS_SaveChannelName(uint8_t channel, const char * name)
 {
-    uint16_t offset = channel * 16;
+    uint16_t offset = SETTINGS_ChannelBankBase() + channel * 16;
     uint8_t buf[16] = {0};
     memcpy(buf, name, MIN(strlen(name), 10u));
     EEPROM_WriteBuffer(0x0F50 + offset, buf);
     EEPROM_WriteBuffer(0x0F58 + offset, buf + 8);
+    CHCACHE_UpdateName(channel, buf);
 }
 
 void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep, bool check, bool save)
@@ -628,6 +949,8 @@ void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep,
         };        // default attributes
 
     uint16_t offset = 0x0D60 + (channel & ~7u);
+    if (IS_MR_CHANNEL(channel))
+        offset += SETTINGS_ChannelBankBase();
     EEPROM_ReadBuffer(offset, state, sizeof(state));
 
     if (keep) {
@@ -648,6 +971,7 @@ void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep,
     }
 
     gMR_ChannelAttributes[channel] = att;
+    SCANLIST_UpdateChannel(channel, att);
 
     if (IS_MR_CHANNEL(channel)) {   // it's a memory channel
         if (!keep) {
@@ -660,8 +984,10 @@ void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep,
 void SETTINGS_WriteBuildOptions(void)
 {
     uint8_t State[8];
+    uint8_t Stored[8];
 
     EEPROM_ReadBuffer(0x1FF0, State, sizeof(State));
+    memcpy(Stored, State, sizeof(Stored));
     
 State[0] = 0
 #ifdef ENABLE_FMRADIO
@@ -690,5 +1016,35 @@ State[1] = 0
     | (1 << 5)
 #endif
 ;
-    EEPROM_WriteBuffer(0x1FF0, State);
-}
\ No newline at end of file
+    if (memcmp(State, Stored, sizeof(State)) != 0) {
+        EEPROM_WriteBuffer(0x1FF0, State);
+        SETTINGS_SealSettings();
+    }
+}
+
+uint8_t SETTINGS_ChannelBankCount(void)
+{
+    return gEepromSize / CHANNEL_BANK_SIZE;
+}
+
+uint16_t SETTINGS_ChannelBankBase(void)
+{
+    return gEeprom.CHANNEL_BANK * CHANNEL_BANK_SIZE;
+}
+
+// Switch the memory channels over to another bank: its attributes, records
+// and names replace those of the current one in RAM. The caller reloads
+// the VFOs.
+void SETTINGS_SelectChannelBank(uint8_t Bank)
+{
+    if (Bank >= SETTINGS_ChannelBankCount() || Bank == gEeprom.CHANNEL_BANK)
+        return;
+
+    gEeprom.CHANNEL_BANK = Bank;
+
+    EEPROM_ReadLarge(SETTINGS_ChannelBankBase() + 0x0D60, gMR_ChannelAttributes, MR_CHANNEL_LAST + 1);
+    ApplyChannelAttributes();
+    CHCACHE_Init();
+
+    SETTINGS_SaveSettings();
+}
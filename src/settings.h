@@ -100,6 +100,8 @@ enum ACTION_OPT_t {
     ACTION_OPT_PTT,
     ACTION_OPT_WN,
     ACTION_OPT_BACKLIGHT,
+    ACTION_OPT_SNAP_MEM,
+    ACTION_OPT_CH_SEARCH,
     ACTION_OPT_LEN
 };
 
@@ -124,6 +126,26 @@ enum CHANNEL_DisplayMode_t {
 };
 typedef enum CHANNEL_DisplayMode_t CHANNEL_DisplayMode_t;
 
+// decoded and range checked 16 byte channel record, memory channels are
+// stored at channel * 16, VFOs at 0x0C80 + (band * 32) + (VFO * 16)
+typedef struct {
+    uint32_t Frequency;         // 0xFFFFFFFF if never set
+    uint32_t Offset;
+    uint8_t  RxCode;
+    uint8_t  TxCode;
+    uint8_t  RxCodeType : 2,
+             TxCodeType : 2,
+             OffsetDir  : 2,
+             Reverse    : 1,
+             Bandwidth  : 1;
+    uint8_t  Modulation : 3,
+             Power      : 3,
+             BusyLock   : 1,
+             TxLock     : 1;
+    uint8_t  Step       : 5,
+             PttId      : 3;
+} __attribute__((packed)) ChannelRecord_t;
+
 typedef struct {
     uint8_t               ScreenChannel[2]; // current channels set in the radio (memory or frequency channels)
     uint8_t               FreqChannel[2]; // last frequency channels used
@@ -226,12 +248,30 @@ typedef struct {
     BATTERY_Type_t        BATTERY_TYPE;
     uint8_t               S0_LEVEL;
     uint8_t               S9_LEVEL;
+    uint8_t               CHANNEL_BANK;
 } EEPROM_Config_t;
 
 extern EEPROM_Config_t gEeprom;
 
+// Memory channels come in banks of 200. Bank 0 is the classic layout in
+// the first 8 KiB, every further 8 KiB of a larger EEPROM holds one more
+// bank with the same layout (records at +0x0000, attributes at +0x0D60,
+// names at +0x0F50). Only the selected bank is loaded at a time.
+#define CHANNEL_BANK_SIZE 0x2000
+
+typedef enum {
+    SETTINGS_LOAD_OK = 0,   // every block passed its CRC
+    SETTINGS_LOAD_MIGRATED, // older or foreign layout, converted
+    SETTINGS_LOAD_REPAIRED  // corrupted blocks reset to defaults
+} SETTINGS_LoadStatus_t;
+
+extern SETTINGS_LoadStatus_t gSettingsLoadStatus;
+
 void     SETTINGS_InitEEPROM(void);
 void     SETTINGS_LoadCalibration(void);
+void     SETTINGS_DecodeChannelRecord(const uint8_t *pData, ChannelRecord_t *pRecord);
+void     SETTINGS_DecodeChannelName(char *s, const uint8_t *pData);
+void     SETTINGS_FetchChannelRecord(uint16_t Address, ChannelRecord_t *pRecord);
 uint32_t SETTINGS_FetchChannelFrequency(const int channel);
 void     SETTINGS_FetchChannelName(char *s, const int channel);
 void     SETTINGS_FactoryReset(bool bIsAll);
@@ -239,11 +279,19 @@ void     SETTINGS_FactoryReset(bool bIsAll);
     void SETTINGS_SaveFM(void);
 #endif
 void SETTINGS_SaveVfoIndices(void);
+void SETTINGS_SaveVfoFrequency(uint8_t VFO, const VFO_Info_t *pVFO);
 void SETTINGS_SaveSettings(void);
+void SETTINGS_CommitSettings(void);
+void SETTINGS_SealSettings(void);
+bool SETTINGS_IsSettingsBlock(uint16_t Address, uint16_t Size);
+void SETTINGS_TimeSlice500ms(void);
 void SETTINGS_SaveChannelName(uint8_t channel, const char * name);
 void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO, uint8_t Mode);
 void SETTINGS_SaveBatteryCalibration(const uint16_t * batteryCalibration);
 void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep, bool check, bool save);
 void SETTINGS_WriteBuildOptions(void);
+uint8_t  SETTINGS_ChannelBankCount(void);
+uint16_t SETTINGS_ChannelBankBase(void);
+void     SETTINGS_SelectChannelBank(uint8_t Bank);
 
 #endif
@@ -0,0 +1,56 @@
+#ifdef ENABLE_CHAN_SEARCH
+
+#include "app/chsearch.h"
+#include "chcache.h"
+#include "driver/st7565.h"
+#include "misc.h"
+#include "ui/chsearch.h"
+#include "ui/graphics.h"
+
+#define RESULT_ROWS 5
+
+void UI_DisplayChannelSearch(void)
+{
+    char    name[11];
+    uint8_t rank  = 0;
+    uint8_t first = 0;
+    uint8_t row   = 0;
+
+    UI_ClearScreen();
+
+    PrintMediumEx(1, 16, POS_L, C_FILL, "FIND:%s_", gChSearchQuery);
+    PrintSmallEx(LCD_WIDTH - 1, 15, POS_R, C_FILL, "%u", CHANNELSET_Count(&gChSearchMatches));
+    DrawHLine(0, 18, LCD_WIDTH, C_FILL);
+
+    if (gChSearchChannel == 0xFF) {
+        PrintMediumEx(LCD_WIDTH / 2, 40, POS_C, C_FILL, "NO MATCH");
+        ST7565_BlitFullScreen();
+        return;
+    }
+
+    // keep the highlighted match on screen
+    for (uint8_t ch = MR_CHANNEL_FIRST; ch < gChSearchChannel; ch++)
+        rank += CHANNELSET_Contains(&gChSearchMatches, ch);
+    if (rank >= RESULT_ROWS)
+        first = rank - RESULT_ROWS + 1;
+
+    rank = 0;
+    for (uint8_t ch = MR_CHANNEL_FIRST; IS_MR_CHANNEL(ch) && row < RESULT_ROWS; ch++) {
+        if (!CHANNELSET_Contains(&gChSearchMatches, ch) || rank++ < first)
+            continue;
+
+        const uint8_t y = 26 + row * 9;
+        const bool    selected = (ch == gChSearchChannel);
+
+        if (selected)
+            FillRect(0, y - 6, LCD_WIDTH, 8, C_FILL);
+
+        CHCACHE_FetchName(name, ch);
+        PrintSmallEx(1, y, POS_L, selected ? C_CLEAR : C_FILL, "%03u %s", ch + 1, name);
+        row++;
+    }
+
+    ST7565_BlitFullScreen();
+}
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef UI_CHSEARCH_H
+#define UI_CHSEARCH_H
+
+#ifdef ENABLE_CHAN_SEARCH
+void UI_DisplayChannelSearch(void);
+#endif
+
+#endif
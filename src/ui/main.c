@@ -21,6 +21,7 @@
 #include "am_fix.h"
 #include "bitmaps.h"
 #include "board.h"
+#include "chcache.h"
 #include "driver/bk4819.h"
 #include "driver/st7565.h"
 #include "driver/uart.h"
@@ -181,10 +182,11 @@ static void DisplaySingleVfo(uint8_t activeVFO) {
         PrintMediumEx(1, 24, POS_L, C_FILL, "SQL%d", gEeprom.SQUELCH_LEVEL);
     }
 
-    // Channel name
-    if(IS_MR_CHANNEL(screenChannel)) {
+    // Channel name (or the name of the memory on the VFO frequency)
+    {
         char string[22];
-        SETTINGS_FetchChannelName(string, screenChannel);
+        const uint8_t nameChannel = IS_MR_CHANNEL(screenChannel) ? screenChannel : CHCACHE_FindChannel(frequency);
+        SETTINGS_FetchChannelName(string, nameChannel);
         if (string[0] != 0) {
             PrintMediumBoldEx(LCD_WIDTH, 25, POS_R, C_FILL, "%10s", string);
         }
@@ -297,6 +299,13 @@ static void printVfoBlock(uint8_t base, uint8_t vfoNum, bool isActive) {
             PrintBiggestDigitsEx(LCD_WIDTH - 14, base + 15, POS_R, C_FILL, 
                 "%4u.%03u", (frequency / 100000), (frequency / 100 % 1000));
             PrintMediumEx(LCD_WIDTH - 1, base + 15, POS_R, C_FILL, "%02u", frequency % 100);
+
+            // name of the memory channel on this frequency, if any
+            char string[22];
+            SETTINGS_FetchChannelName(string, CHCACHE_FindChannel(frequency));
+            if (string[0] != 0) {
+                PrintSmallEx(LCD_WIDTH - 1, base + 7, POS_R, C_FILL, "%s", string);
+            }
         }
     } else {
         char string[22];
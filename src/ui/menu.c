@@ -60,6 +60,7 @@ const t_menu_item MenuList[] =
     {"ChSave",      MENU_MEM_CH        }, // was "MEM-CH"
     {"ChDele",      MENU_DEL_CH        }, // was "DEL-CH"
     {"ChName",      MENU_MEM_NAME      },
+    {"ChBank",      MENU_CH_BANK       },
 
     {"SList",       MENU_S_LIST        },
     {"SList1",      MENU_SLIST1        },
@@ -336,6 +337,10 @@ const t_sidefunction gSubMenu_SIDEFUNCTIONS[] =
     {"MAIN ONLY",       ACTION_OPT_MAINONLY},
     {"PTT",             ACTION_OPT_PTT},
     {"WIDE\nNARROW",    ACTION_OPT_WN},
+    {"SNAP\nMEM",       ACTION_OPT_SNAP_MEM},
+#ifdef ENABLE_CHAN_SEARCH
+    {"FIND\nCHANNEL",   ACTION_OPT_CH_SEARCH},
+#endif
 };
 
 const uint8_t gSubMenu_SIDEFUNCTIONS_size = ARRAY_SIZE(gSubMenu_SIDEFUNCTIONS);
@@ -694,6 +699,11 @@ void UI_DisplayMenu(void)
             sprintf(String, "%02dm:%02ds", (((gSubMenuSelection + 1) * 5) / 60), (((gSubMenuSelection + 1) * 5) % 60));
             break;
 
+        case MENU_CH_BANK:
+            sprintf(String, "BANK %u\n%u-%u", gSubMenuSelection + 1,
+                    gSubMenuSelection * (MR_CHANNEL_LAST + 1) + 1, (gSubMenuSelection + 1) * (MR_CHANNEL_LAST + 1));
+            break;
+
         case MENU_SC_REV:
             if(gSubMenuSelection == 0)
             {
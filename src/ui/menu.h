@@ -46,6 +46,7 @@ enum
     MENU_MEM_CH,
     MENU_DEL_CH,
     MENU_MEM_NAME,
+    MENU_CH_BANK,
     MENU_MDF,
     MENU_SAVE,
     MENU_ABR,
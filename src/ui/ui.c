@@ -24,6 +24,9 @@
 #endif
 #include "driver/keyboard.h"
 #include "misc.h"
+#ifdef ENABLE_CHAN_SEARCH
+    #include "ui/chsearch.h"
+#endif
 #ifdef ENABLE_FMRADIO
     #include "ui/fmradio.h"
 #endif
@@ -49,6 +52,9 @@ void (*UI_DisplayFunctions[])(void) = {
 #ifdef ENABLE_FMRADIO
     [DISPLAY_FM] = &UI_DisplayFM,
 #endif
+#ifdef ENABLE_CHAN_SEARCH
+    [DISPLAY_CHSEARCH] = &UI_DisplayChannelSearch,
+#endif
 };
 
 static_assert(ARRAY_SIZE(UI_DisplayFunctions) == DISPLAY_N_ELEM);
@@ -27,6 +27,9 @@ enum GUI_DisplayType_t
     DISPLAY_SCANNER,
 #ifdef ENABLE_FMRADIO
     DISPLAY_FM,
+#endif
+#ifdef ENABLE_CHAN_SEARCH
+    DISPLAY_CHSEARCH,
 #endif
     DISPLAY_N_ELEM,
     DISPLAY_INVALID = 0xFFu
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""Run the radio's spectrum as a headless band monitor.
+
+Sets up the sweep, arms or disarms the trigger and prints the strongest
+peaks of each new sweep, for watching a band unattended. With the
+trigger armed the radio stops on a peak above it and listens until it
+goes away, as it does when used by hand; disarmed, it just sweeps.
+
+    utils/band_monitor.py /dev/ttyUSB0 --range 144-146 --no-trigger
+    utils/band_monitor.py /dev/ttyUSB0 --center 446.1 --step 6.25 \\
+        --steps 64 --trigger -110
+    utils/band_monitor.py /dev/ttyUSB0 --listen 145.5 --monitor
+
+The spectrum keeps running after ^C unless --stop is given; --exit
+alone just leaves it.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from radio_link import CAP_SPECTRUM, SPECTRUM_STEPS, Link, LinkError, Port
+
+STEPS_COUNTS = (128, 64, 32, 16)
+BANDWIDTHS = {"25": 0, "12.5": 1, "6.25": 2}
+MODULATIONS = {"fm": 0, "am": 1, "usb": 2}
+STATES = ("sweep", "frequency input", "still")
+
+SPECTRUM_QUERY = 0
+SPECTRUM_SET = 1
+SPECTRUM_EXIT = 2
+
+STATUS = struct.Struct("<IIIHHHHBBBBBBBBb3x")
+PEAK = struct.Struct("<IHH")
+
+START_WAIT = 2.0    # seconds for the main loop to start the spectrum
+
+
+class Status:
+    def __init__(self, payload):
+        (self.start, self.end, self.frequency, self.step, self.steps,
+         self.trigger, self.sweeps, self.step_index, self.steps_index,
+         self.listen_bw, self.modulation, self.state, self.running,
+         self.armed, self.listening, self.correction) = \
+            STATUS.unpack(payload[:STATUS.size])
+
+    def dbm(self, rssi):
+        return rssi / 2 - 160 + self.correction
+
+    def __str__(self):
+        if not self.running:
+            return "spectrum not running"
+        text = "%.5f-%.5f MHz, %i steps of %.2f kHz, %s" % (
+            self.start / 1e5, self.end / 1e5, self.steps, self.step / 100,
+            STATES[self.state] if self.state < len(STATES) else self.state)
+        if self.armed:
+            text += ", trigger %.1f dBm" % self.dbm(self.trigger)
+        else:
+            text += ", trigger off"
+        if self.listening:
+            text += ", listening at %.5f MHz" % (self.frequency / 1e5)
+        return text
+
+
+def mhz(text):
+    return int(round(float(text) * 1e5))
+
+
+def rssi(dbm, correction):
+    return max(1, int(round((dbm + 160 - correction) * 2)))
+
+
+def fit_range(low, high):
+    """(center, step index, steps count index) of the finest sweep that
+    covers low..high"""
+    span = high - low
+    for index, step in enumerate(SPECTRUM_STEPS):
+        for count_index in reversed(range(len(STEPS_COUNTS))):
+            if step * STEPS_COUNTS[count_index] >= span:
+                return (low + high) // 2, index, count_index
+    raise SystemExit("range too wide for one sweep")
+
+
+def query(link, action=SPECTRUM_QUERY, setup=(0, 0, 0, 0, 0)):
+    center, step, count, bw, modulation = setup
+    link.send(0x0549, struct.pack("<IBBBBB3x", center, action, step, count,
+                                  bw, modulation))
+    return Status(link.expect(0x054A))
+
+
+def set_trigger(link, level, armed):
+    link.send(0x054B, struct.pack("<H?x", level, armed))
+    return Status(link.expect(0x054C))
+
+
+def listen(link, frequency, monitor):
+    link.send(0x054F, struct.pack("<I?3x", frequency, monitor))
+    return Status(link.expect(0x0550))
+
+
+def peaks(link, count, rssi_min):
+    link.send(0x054D, struct.pack("<BxH", count, rssi_min))
+    data = link.expect(0x054E)
+    sweeps, found = struct.unpack("<HB", data[:3])
+    return sweeps, [PEAK.unpack_from(data, 4 + i * PEAK.size)
+                    for i in range(found)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", help="serial port of the programming cable")
+    where = parser.add_mutually_exclusive_group()
+    where.add_argument("--center", type=mhz, help="MHz to sweep around")
+    where.add_argument("--range", help="MHz to MHz to sweep, e.g. 144-146")
+    parser.add_argument("--step", type=float, default=25,
+                        help="kHz between steps with --center")
+    parser.add_argument("--steps", type=int, choices=STEPS_COUNTS,
+                        default=64, help="steps a sweep with --center")
+    parser.add_argument("--bw", choices=BANDWIDTHS, default="25",
+                        help="kHz listening bandwidth")
+    parser.add_argument("--mod", choices=MODULATIONS, default="fm")
+    trigger = parser.add_mutually_exclusive_group()
+    trigger.add_argument("--trigger", type=float, metavar="DBM",
+                         help="arm the trigger at this level")
+    trigger.add_argument("--no-trigger", action="store_true",
+                         help="never stop on a peak")
+    parser.add_argument("--listen", type=mhz, metavar="MHZ",
+                        help="listen here instead of sweeping")
+    parser.add_argument("--monitor", action="store_true",
+                        help="keep listening whatever the trigger says")
+    parser.add_argument("--peaks", type=int, default=4,
+                        help="peaks to show a sweep (max 16)")
+    parser.add_argument("--min", type=float, default=-130, metavar="DBM",
+                        help="weakest peak to show")
+    parser.add_argument("--interval", type=float, default=1.0,
+                        help="seconds between looks at the peaks")
+    parser.add_argument("--stop", action="store_true",
+                        help="leave the spectrum on ^C")
+    parser.add_argument("--exit", action="store_true",
+                        help="just leave the spectrum")
+    args = parser.parse_args()
+
+    link = Link(Port(args.port))
+    firmware, caps = link.hello()
+    if not caps & CAP_SPECTRUM:
+        sys.exit("%s has no remote spectrum" % (firmware or "the radio"))
+
+    if args.exit:
+        print(query(link, SPECTRUM_EXIT))
+        return
+
+    status = query(link)
+    if args.center is not None or args.range or not status.running:
+        if args.range:
+            low, _, high = args.range.partition("-")
+            center, step, count = fit_range(mhz(low), mhz(high))
+        else:
+            center = args.center
+            if center is None:
+                sys.exit("the spectrum is not running, give --center or "
+                         "--range")
+            step = min(range(len(SPECTRUM_STEPS)), key=lambda i:
+                       abs(SPECTRUM_STEPS[i] - args.step * 100))
+            count = STEPS_COUNTS.index(args.steps)
+        query(link, SPECTRUM_SET, (center, step, count,
+                                   BANDWIDTHS[args.bw],
+                                   MODULATIONS[args.mod]))
+        end = time.monotonic() + START_WAIT
+        while not query(link).running:
+            if time.monotonic() > end:
+                sys.exit("the radio did not start the spectrum")
+            time.sleep(0.1)
+
+    status = query(link)
+    if args.no_trigger:
+        status = set_trigger(link, 0, False)
+    elif args.trigger is not None:
+        status = set_trigger(link, rssi(args.trigger, status.correction),
+                             True)
+    if args.listen:
+        status = listen(link, args.listen, args.monitor)
+    print(status, file=sys.stderr)
+
+    rssi_min = rssi(args.min, status.correction)
+    last = None
+    try:
+        while True:
+            try:
+                sweeps, found = peaks(link, args.peaks, rssi_min)
+            except LinkError as e:
+                print("no peaks: %s" % e, file=sys.stderr)
+                time.sleep(args.interval)
+                continue
+            if sweeps != last:
+                last = sweeps
+                print("%s %5i  %s" % (
+                    time.strftime("%H:%M:%S"), sweeps,
+                    "  ".join("%.5f %.1f" % (f / 1e5, status.dbm(level))
+                              for f, level, _ in found) or "-"),
+                    flush=True)
+            time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if args.stop:
+            query(link, SPECTRUM_EXIT)
+
+
+if __name__ == "__main__":
+    main()
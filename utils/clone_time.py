@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Time a download with the chirp driver against utils/fake_radio.py.
+
+The stand-in radio keeps the pace of a real one (--realtime), so the
+figures compare the ways the driver can read a radio: a request at a
+time as with the stock firmware, several requests in flight, bulk reads
+and a faster baud rate. Every download is checked against the image the
+radio was given. The chirp package the driver imports has to be
+importable, e.g. from a chirp checkout:
+
+    PYTHONPATH=~/chirp utils/clone_time.py
+"""
+
+import argparse
+import importlib.util
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import time
+
+from radio_link import Port
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DRIVER = os.path.join(HERE, "..", "chirp", "uvk5_miramir.py")
+FAKE_RADIO = os.path.join(HERE, "fake_radio.py")
+
+# capabilities the radio advertises, see fake_radio.py
+RUNS = (
+    (0x00, "one request at a time"),
+    (0x08, "requests in flight"),
+    (0x09, "bulk requests in flight"),
+    (0x0F, "all of the above at 115200"),
+)
+
+
+class Radio:
+    """what do_download wants of a chirp radio"""
+
+    BAUD_RATE = 38400
+    FIRMWARE_VERSION = ""
+
+    def __init__(self, pipe):
+        self.pipe = pipe
+
+    def status_fn(self, status):
+        pass
+
+
+def load_driver():
+    spec = importlib.util.spec_from_file_location("uvk5_miramir", DRIVER)
+    driver = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(driver)
+    return driver
+
+
+def clone(driver, image, caps, ring):
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "eeprom.bin")
+        with open(path, "wb") as f:
+            f.write(image)
+
+        radio = subprocess.Popen([sys.executable, FAKE_RADIO, "--realtime",
+                                  "--image", path, "--caps", str(caps),
+                                  "--ring", str(ring)],
+                                 stdout=subprocess.PIPE, text=True)
+        try:
+            port = Port(radio.stdout.readline().strip(), Radio.BAUD_RATE)
+            start = time.monotonic()
+            mmap = driver.do_download(Radio(port))
+            elapsed = time.monotonic() - start
+            port.close()
+        finally:
+            radio.terminate()
+            radio.wait()
+
+    return elapsed, mmap.get_packed() == image
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--ring", type=int, default=256,
+                        help="receive ring size of the radio")
+    parser.add_argument("--caps", type=lambda x: int(x, 0), action="append",
+                        help="time just these capabilities (repeatable)")
+    args = parser.parse_args()
+
+    driver = load_driver()
+    random.seed(0)
+    image = bytes(random.randrange(256) for _ in range(driver.MEM_SIZE))
+
+    runs = RUNS
+    if args.caps:
+        runs = [(caps, "") for caps in args.caps]
+
+    failed = False
+    for caps, what in runs:
+        elapsed, good = clone(driver, image, caps, args.ring)
+        print("caps 0x%02x  %6.2f s  %s%s" % (caps, elapsed, what,
+                                               "" if good else "  MISMATCH"))
+        failed |= not good
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
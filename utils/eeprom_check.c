@@ -0,0 +1,438 @@
+// Host check of the EEPROM driver and the VFO journal against a simulated
+// 24C64..24C512 on the I2C bus: size detection (with and without the
+// settings seal), banked writes through the page buffer, journal
+// recovery after a reboot or a power cut in the middle of a flush, and
+// the bus traffic of the boot time reads against what they used to be.
+//
+//   gcc -std=c2x -fshort-enums -I src -o eeprom_check utils/eeprom_check.c
+//   ./eeprom_check
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/eeprom.c"
+#include "journal.c"
+#include "channelset.c"
+#include "chcache.c"
+#include "misc.c"
+#include "scanlist.c"
+#include "settings.c"
+
+// ---- the rest of the firmware the settings reach ----
+
+VFO_Info_t *gRxVfo;
+uint16_t    gBatteryCalibration[6];
+
+void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data)
+{
+    (void)Register;
+    (void)Data;
+}
+
+bool DTMF_ValidateCodes(char *pCode, const unsigned int size)
+{
+    (void)pCode;
+    (void)size;
+    return true;
+}
+
+FREQUENCY_Band_t FREQUENCY_GetBand(uint32_t Frequency)
+{
+    (void)Frequency;
+    return BAND6_400MHz;
+}
+
+bool RADIO_CheckValidChannel(uint16_t channel, bool checkScanList, uint8_t scanList)
+{
+    (void)checkScanList;
+    (void)scanList;
+    return IS_MR_CHANNEL(channel);
+}
+
+void RADIO_InitInfo(VFO_Info_t *pInfo, const uint8_t ChannelSave, const uint32_t Frequency)
+{
+    (void)pInfo;
+    (void)ChannelSave;
+    (void)Frequency;
+}
+
+// CRC-16/XMODEM, what the CRC unit is set up for
+uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size)
+{
+    const uint8_t *pData = pBuffer;
+    uint16_t       crc   = 0;
+
+    while (Size--) {
+        crc ^= *pData++ << 8;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// ---- simulated part ----
+
+static uint8_t  gChip[EEPROM_SIZE_MAX];
+static uint32_t gChipSize;
+static uint16_t gChipAddress;
+static int      gChipState;       // bytes written since the start condition
+static bool     gChipWrote;
+static int      gPageWrites;
+static int      gPowerLeft = -1;  // page writes until the power fails, -1 never
+
+// bus traffic: start conditions, stops, bytes each way
+typedef struct {
+    unsigned int Starts, Stops, Out, In;
+} Bus_t;
+
+static Bus_t gBus;
+
+void I2C_Start(void)
+{
+    gBus.Starts++;
+    gChipState = 0;
+    gChipWrote = false;
+}
+
+void I2C_Stop(void)
+{
+    gBus.Stops++;
+    if (!gChipWrote)
+        return;
+
+    gPageWrites++;
+    if (gPowerLeft > 0)
+        gPowerLeft--;
+}
+
+int I2C_Write(uint8_t Data)
+{
+    gBus.Out++;
+    switch (gChipState++) {
+    case 0:
+        gChipState = (Data & 1) ? 3 : 1;
+        return 0;
+    case 1:
+        gChipAddress = Data << 8;
+        return 0;
+    case 2:
+        gChipAddress |= Data;
+        return 0;
+    }
+
+    // the part ignores the address bits above its size and wraps within
+    // the page it writes, which it burns whole or not at all
+    if (gPowerLeft != 0)
+        gChip[gChipAddress & (gChipSize - 1)] = Data;
+    gChipAddress = (gChipAddress & ~(EEPROM_PAGE_SIZE - 1)) | ((gChipAddress + 1) & (EEPROM_PAGE_SIZE - 1));
+    gChipWrote = true;
+    return 0;
+}
+
+int I2C_WriteBuffer(const void *pBuffer, uint8_t Size)
+{
+    for (uint8_t i = 0; i < Size; i++)
+        I2C_Write(((const uint8_t *)pBuffer)[i]);
+    return 0;
+}
+
+uint8_t I2C_ReadFast(bool bFinal)
+{
+    (void)bFinal;
+    gBus.In++;
+    return gChip[gChipAddress++ & (gChipSize - 1)];
+}
+
+void SYSTICK_DelayUs(uint32_t Delay)
+{
+    (void)Delay;
+}
+
+// the RAM of the firmware after a reset
+static void Reboot(void)
+{
+    for (unsigned int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+        gPages[i].Address = EEPROM_PAGE_FREE;
+        gPages[i].Dirty   = false;
+    }
+    gBurning   = false;
+    gPowerLeft = -1;
+}
+
+// ---- size detection and banks ----
+
+static void CheckSize(uint32_t Size, bool Sealed)
+{
+    static uint8_t before[EEPROM_SIZE_MAX];
+
+    gChipSize = Size;
+    memset(gChip, 0xFF, sizeof(gChip));
+    for (uint32_t i = 0; i < Size; i += 97)
+        gChip[i] = i * 7;
+    for (uint32_t a = 0x1FA0; a < Size; a += CHANNEL_BANK_SIZE)
+        memset(gChip + a, 0xFF, 32);
+    if (Sealed)
+        memcpy(gChip + 0x1FA0, "\x77\x5E\x02", 3);
+    memcpy(before, gChip, Size);
+
+    Reboot();
+    gPageWrites = 0;
+    EEPROM_DetectSize();
+    assert(gEepromSize == Size);
+    assert(memcmp(before, gChip, Size) == 0);
+
+    const int probeWrites = gPageWrites;
+
+    // the same name slot in every bank, no bank may alias another
+    for (uint32_t b = 0; b < Size / CHANNEL_BANK_SIZE; b++) {
+        const uint8_t data[8] = { b + 1, 1, 2, 3, 4, 5, 6, 7 };
+        EEPROM_WriteBuffer(b * CHANNEL_BANK_SIZE + 0x0F50, data);
+    }
+    EEPROM_Flush();
+    for (uint32_t b = 0; b < Size / CHANNEL_BANK_SIZE; b++) {
+        uint8_t data[8];
+        EEPROM_ReadBuffer(b * CHANNEL_BANK_SIZE + 0x0F50, data, sizeof(data));
+        assert(data[0] == b + 1);
+        assert(gChip[b * CHANNEL_BANK_SIZE + 0x0F50] == b + 1);
+    }
+
+    printf("size %05X sealed %d: ok, %d probe writes\n", (unsigned)Size, Sealed, probeWrites);
+}
+
+// ---- journal ----
+
+// what the radio should come back up with
+typedef struct {
+    uint32_t Frequency[SLOT_COUNT];
+    uint8_t  Indices[6];
+} State_t;
+
+// what SETTINGS_InitEEPROM() does with the indices the journal patched
+static void UseIndices(const uint8_t *pIndices)
+{
+    gEeprom.ScreenChannel[0] = pIndices[0];
+    gEeprom.MrChannel[0]     = pIndices[1];
+    gEeprom.FreqChannel[0]   = pIndices[2];
+    gEeprom.ScreenChannel[1] = pIndices[3];
+    gEeprom.MrChannel[1]     = pIndices[4];
+    gEeprom.FreqChannel[1]   = pIndices[5];
+}
+
+static void SetIndices(uint8_t *pIndices)
+{
+    for (int i = 0; i < 6; i++)
+        pIndices[i] = rand() % 200;
+    UseIndices(pIndices);
+}
+
+static uint32_t HomeFrequency(uint8_t Slot)
+{
+    uint32_t f;
+    EEPROM_ReadBuffer(SlotAddress(Slot), &f, sizeof(f));
+    return f;
+}
+
+static void Boot(State_t *pState)
+{
+    uint8_t indices[8];
+
+    EEPROM_ReadBuffer(VFO_INDICES, indices, sizeof(indices));
+    JOURNAL_Init(indices);
+    memcpy(pState->Indices, indices, sizeof(pState->Indices));
+    UseIndices(pState->Indices);
+
+    for (uint8_t s = 0; s < SLOT_COUNT; s++) {
+        const uint8_t channel = FREQ_CHANNEL_FIRST + s % (SLOT_COUNT / 2);
+        if (!JOURNAL_GetFrequency(channel, s / (SLOT_COUNT / 2), &pState->Frequency[s]))
+            pState->Frequency[s] = HomeFrequency(s);
+    }
+}
+
+// one random change the firmware makes, applied to the expected state too
+static void Change(State_t *pState)
+{
+    const uint8_t s       = rand() % SLOT_COUNT;
+    const uint8_t channel = FREQ_CHANNEL_FIRST + s % (SLOT_COUNT / 2);
+    const uint8_t vfo     = s / (SLOT_COUNT / 2);
+    const uint32_t f      = 10000000 + rand() % 50000000;
+
+    switch (rand() % 8) {
+    case 0:     // SETTINGS_SaveChannel() of a VFO: home record, then forget
+        EEPROM_WriteBuffer(SlotAddress(s), &(uint32_t[2]){ f, 0 });
+        JOURNAL_Forget(channel, vfo);
+        pState->Frequency[s] = f;
+        break;
+    case 1:     // the programming software reads the VFOs
+        JOURNAL_Fold();
+        break;
+    case 2:
+    case 3:
+        SetIndices(pState->Indices);
+        JOURNAL_SaveIndices();
+        break;
+    default:    // a scan stopping, a frequency typed in
+        JOURNAL_SaveFrequency(channel, vfo, f);
+        pState->Frequency[s] = f;
+        break;
+    }
+}
+
+static void CheckJournal(unsigned int Seed, bool PowerCuts)
+{
+    State_t expected;
+    State_t steps[5];   // before and after each change of a round
+    State_t booted;
+
+    srand(Seed);
+
+    gChipSize = EEPROM_SIZE_MIN;
+    memset(gChip, 0xFF, sizeof(gChip));
+    for (uint8_t s = 0; s < SLOT_COUNT; s++) {
+        const uint32_t f = 14400000 + s * 12500;
+        memcpy(gChip + SlotAddress(s), &f, sizeof(f));
+    }
+
+    Reboot();
+    gEepromSize = EEPROM_SIZE_MIN;
+    Boot(&expected);
+
+    for (int round = 0; round < 2000; round++) {
+        const int changes = 1 + rand() % 4;
+
+        steps[0] = expected;
+        for (int i = 0; i < changes; i++) {
+            Change(&expected);
+            steps[i + 1] = expected;
+        }
+
+        // what the app flushes every 500 ms, possibly cut short
+        if (PowerCuts && rand() % 4 == 0) {
+            gPowerLeft = rand() % 3;
+            EEPROM_Flush();
+            Reboot();
+            Boot(&booted);
+            // every VFO comes back with a frequency it had in this round,
+            // never with an older one
+            for (uint8_t s = 0; s < SLOT_COUNT; s++) {
+                bool seen = false;
+                for (int i = 0; i <= changes; i++)
+                    seen |= booted.Frequency[s] == steps[i].Frequency[s];
+                assert(seen);
+            }
+            expected = booted;
+        } else {
+            EEPROM_Flush();
+        }
+
+        if (rand() % 8 == 0) {
+            Reboot();
+            Boot(&booted);
+            assert(memcmp(booted.Frequency, expected.Frequency, sizeof(booted.Frequency)) == 0);
+            assert(memcmp(booted.Indices, expected.Indices, sizeof(booted.Indices)) == 0);
+        }
+    }
+
+    printf("journal seed %u%s: ok\n", Seed, PowerCuts ? " with power cuts" : "");
+}
+
+// ---- boot reads ----
+
+// what SETTINGS_InitEEPROM() and SETTINGS_LoadCalibration() read before the
+// settings area was streamed, one transaction each (no FM radio)
+static const struct {
+    uint16_t Address;
+    uint8_t  Size;
+} gOldBootReads[] = {
+    { 0x0E70, 8 }, { 0x0E78, 8 }, { 0x0E80, 8 }, { 0x0E90, 8 },
+    { 0x0EA0, 8 }, { 0x0EA8, 8 }, { 0x0ED0, 8 }, { 0x0ED8, 8 },
+    { 0x0EF8, 16 }, { 0x0F08, 16 }, { 0x0F18, 8 }, { 0x0F40, 8 },
+    { 0x0D60, 200 }, { 0x0F30, 16 }, { 0x1FF0, 8 },
+    { 0x1EC0, 8 }, { 0x1EC8, 8 }, { 0x1F40, 12 }, { 0x1F88, 8 },
+};
+
+static Bus_t TakeBus(void)
+{
+    const Bus_t bus = gBus;
+    memset(&gBus, 0, sizeof(gBus));
+    return bus;
+}
+
+// Bus time as driver/i2c.c clocks it: 4 us a start or stop, 28 us a byte
+// written, 37 us a byte read the standard way and 24.7 us in fast mode.
+static void Report(const char *pName, Bus_t bus, unsigned int ReadNs)
+{
+    const unsigned int us = (bus.Starts + bus.Stops) * 4 + bus.Out * 28 + bus.In * ReadNs / 1000;
+
+    printf("boot %-20s %3u transactions %5u bytes %4u.%u ms\n",
+        pName, bus.Stops, bus.Out + bus.In, us / 1000, us % 1000 / 100);
+}
+
+static void CheckBoot(void)
+{
+    uint8_t buf[200];
+
+    // a radio that has been set up: sealed settings, some channels
+    gChipSize = EEPROM_SIZE_MIN;
+    memset(gChip, 0xFF, sizeof(gChip));
+    for (unsigned int ch = 0; ch < 50; ch++) {
+        const uint32_t f = 14400000 + ch * 2500;
+        memcpy(gChip + ch * 16, &f, sizeof(f));
+        memcpy(gChip + 0x0F50 + ch * 16, "CHANNEL", 7);
+    }
+    Reboot();
+    EEPROM_DetectSize();
+    SETTINGS_InitEEPROM();
+    EEPROM_Flush();
+
+    Reboot();
+    TakeBus();
+    for (unsigned int i = 0; i < sizeof(gOldBootReads) / sizeof(gOldBootReads[0]); i++)
+        EEPROM_ReadBuffer(gOldBootReads[i].Address, buf, gOldBootReads[i].Size);
+    const Bus_t before = TakeBus();
+
+    EEPROM_DetectSize();
+    const Bus_t detect = TakeBus();
+
+    // SETTINGS_InitEEPROM() also scans the journal and fills the channel
+    // cache, neither of which the old boot had: take their share out
+    SETTINGS_InitEEPROM();
+    SETTINGS_LoadCalibration();
+    Bus_t after = TakeBus();
+    JOURNAL_Init(buf);
+    const Bus_t journal = TakeBus();
+    CHCACHE_Init();
+    const Bus_t cache = TakeBus();
+    after.Starts -= journal.Starts + cache.Starts;
+    after.Stops  -= journal.Stops  + cache.Stops;
+    after.Out    -= journal.Out    + cache.Out;
+    after.In     -= journal.In     + cache.In;
+    assert(!EEPROM_IsDirty());
+
+    Report("settings before", before, 37000);
+    Report("settings after", after, 24667);
+    Report("size detection", detect, 24667);
+    Report("journal", journal, 24667);
+    Report("channel cache", cache, 24667);
+}
+
+int main(void)
+{
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    for (uint32_t size = EEPROM_SIZE_MIN; size <= EEPROM_SIZE_MAX; size *= 2) {
+        CheckSize(size, false);
+        CheckSize(size, true);
+    }
+
+    CheckBoot();
+
+    for (unsigned int seed = 1; seed <= 20; seed++) {
+        CheckJournal(seed, false);
+        CheckJournal(seed, true);
+    }
+
+    printf("all ok\n");
+    return 0;
+}
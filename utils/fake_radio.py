@@ -0,0 +1,603 @@
+#!/usr/bin/env python3
+"""Stand-in for a UV-K5 on a pseudo terminal, for testing programming
+software on Linux without a radio.
+
+It speaks the programming protocol of this firmware over an EEPROM image
+and prints the pty to point the software at. The baud rate the host sets
+on the pty is honoured: bytes sent at a rate the radio is not listening
+at are lost, just like on the real cable, so baud rate changes and their
+fallback can be exercised. With --realtime it also keeps the radio's
+pace, for timing programming software: bytes take their time on the
+wire, one command is handled per 10 ms main loop slice and the receive
+ring overruns when the host sends too far ahead.
+
+    utils/fake_radio.py --image eeprom.bin
+"""
+
+import argparse
+import os
+import pty
+import random
+import select
+import signal
+import struct
+import sys
+import termios
+import time
+import tty
+
+from radio_link import (CAP_BAUD_RATE, CAP_BLOCK_CRC, CAP_BULK, CAP_FLOW,
+                        CAP_REMOTE, CAP_SPECTRUM, CAP_TELEMETRY, CAP_TRACE,
+                        CAPS_MAGIC, OBFUSCATION, SPECTRUM_STEPS, crc16,
+                        rle_encode, xor)
+
+BAUD_DEFAULT = 38400
+BAUD_RATES = (38400, 57600, 115200, 230400)
+BAUD_CONFIRM = 2.0      # seconds to hear from the host at a new rate
+SESSION_IDLE = 6.0      # end of the programming session
+SLICE = 0.010           # the main loop looks for a command this often
+CHAR_BITS = 10          # start, 8 data and stop bits
+
+BULK_READ_MAX = 128
+CRC_BLOCK_SIZE = 256
+CRC_BLOCKS_MAX = 4
+TELEMETRY_PERIOD_MIN = 2    # 10 ms units
+TELEMETRY_LEASE = 30.0
+SCREEN_PAGES = 8
+SCREEN_WIDTH = 128
+SCREEN_DATA_MAX = 256 - 1 - 16     # transmit ring less the rest of a reply
+KEY_PTT = 16
+KEY_INVALID = 19
+KEY_RELEASE = 0.05
+TRACE_PERIOD = 0.060    # a scan step
+# events from src/helper/trace.h
+TRACE_FUNCTION = 2
+TRACE_SCAN_CHANNEL = 4
+TRACE_SCAN_FOUND = 6
+FUNCTION_INCOMING = 3
+FUNCTION_RECEIVE = 4
+SWEEP_STEP = 0.003      # seconds the spectrum spends on a step
+SPECTRUM_PEAKS_MAX = 16
+SCAN_HIT_EVERY = 5.0    # seconds between made up scan hits
+SCANLOG_KEPT = 16
+SCANLOG_BATCH = 8
+# carriers on the air for the spectrum to find, 10 Hz and RSSI
+CARRIERS = ((14550000, 120), (14572500, 95), (43350000, 140),
+            (44610625, 110))
+
+SPEEDS = {getattr(termios, "B%i" % b): b for b in
+          (9600, 19200, 38400, 57600, 115200, 230400, 460800)}
+
+
+class Radio:
+    def __init__(self, eeprom, caps, ring, deaf_above, scan_log, verbose):
+        self.eeprom = eeprom
+        self.ring = ring
+        # as the firmware works it out from its receive ring size
+        self.bulk_write_max = min((ring - 1 - 8 - 16) // 32 * 32, 8 * 32)
+        self.caps = caps
+        self.deaf_above = deaf_above
+        self.verbose = verbose
+        self.timestamp = None
+        self.baud = BAUD_DEFAULT
+        self.confirm_by = None
+        self.idle_by = None
+        self.rx = b""
+        self.boot = time.monotonic()
+        self.telemetry = 0          # record period in 10 ms, 0 when off
+        self.telemetry_next = None
+        self.telemetry_until = None
+        self.sequence = 0
+        self.rssi = 100
+        # the screen shows a bar for each key, flipped by each press
+        self.screen = bytearray(SCREEN_PAGES * SCREEN_WIDTH)
+        self.screen[SCREEN_WIDTH - 12:SCREEN_WIDTH - 2] = b"\x7e" * 10
+        self.screen_crcs = None
+        self.screen_pending = 0
+        self.key_busy_until = 0.0
+        self.trace_next = 0.0
+        self.scan_channel = 0
+        # the remote spectrum: (center, step index, steps count index,
+        # bw, modulation) once started
+        self.spectrum = None
+        self.spectrum_since = 0.0
+        self.trigger = 150
+        self.armed = True
+        self.listen_at = 0
+        self.scan_log = scan_log
+        self.hits = []
+        self.hit_next = self.boot + SCAN_HIT_EVERY
+
+    def log(self, fmt, *args):
+        if self.verbose:
+            print(fmt % args, file=sys.stderr)
+
+    def set_baud(self, baud):
+        self.log("radio now at %i baud", baud)
+        self.baud = baud
+        self.confirm_by = None
+        if baud != BAUD_DEFAULT:
+            self.confirm_by = time.monotonic() + BAUD_CONFIRM
+
+    def tick(self):
+        now = time.monotonic()
+        if self.baud == BAUD_DEFAULT:
+            return
+        if self.confirm_by is not None and now >= self.confirm_by:
+            self.log("rate never confirmed, falling back")
+            self.set_baud(BAUD_DEFAULT)
+        elif self.confirm_by is None and (self.idle_by is None
+                                          or now >= self.idle_by):
+            self.log("session over, falling back")
+            self.set_baud(BAUD_DEFAULT)
+
+    def telemetry_due(self):
+        """the next telemetry record, when one is due"""
+        now = time.monotonic()
+        if self.telemetry and now >= self.telemetry_until:
+            self.log("telemetry lease over")
+            self.telemetry = 0
+        if not self.telemetry or now < self.telemetry_next:
+            return None
+        self.telemetry_next += self.telemetry / 100
+        # a made up signal wandering about -110 dBm
+        self.rssi = max(40, min(300, self.rssi + random.randint(-3, 3)))
+        record = struct.pack("<IHHBBBbHBx", int((now - self.boot) * 100),
+                             self.sequence & 0xFFFF, self.rssi,
+                             random.randint(10, 40), random.randint(0, 20),
+                             0, -14, 780, 4)
+        self.sequence += 1
+        return struct.pack("<HH", 0x0542, len(record)) + record
+
+    def trace_due(self):
+        """made up trace events of a memory scan, when due and the radio
+        is not in a programming session"""
+        now = time.monotonic()
+        if not self.caps & CAP_TRACE or now < self.trace_next or \
+                (self.idle_by is not None and now < self.idle_by):
+            return None
+        self.trace_next = now + TRACE_PERIOD
+        self.scan_channel = self.scan_channel % 20 + 1
+        events = [(TRACE_SCAN_CHANNEL, self.scan_channel, 0)]
+        if random.random() < 0.05:
+            events += [(TRACE_SCAN_FOUND, self.scan_channel - 1, 0),
+                       (TRACE_FUNCTION, FUNCTION_INCOMING, FUNCTION_RECEIVE)]
+        ticks = (now - self.boot) * 100
+        record = struct.pack("<B3x", len(events))
+        for event, arg0, arg1 in events:
+            record += struct.pack("<IHBxII", int(ticks),
+                                  int(ticks % 1 * 60000), event, arg0, arg1)
+        return struct.pack("<HH", 0x0548, len(record)) + record
+
+    def spectrum_range(self):
+        center, step, count, _, _ = self.spectrum
+        step = SPECTRUM_STEPS[step]
+        steps = 128 >> count
+        start = center if step < 250 else center - steps * step // 2
+        return start, step, steps
+
+    def spectrum_status(self, reply):
+        if not self.spectrum:
+            status = struct.pack("<IIIHHHHBBBBBBBBb3x", 0, 0, 0, 0, 0,
+                                 self.trigger, 0, 0, 0, 0, 0, 0, False,
+                                 self.armed, False, 0)
+        else:
+            start, step, steps = self.spectrum_range()
+            _, index, count, bw, modulation = self.spectrum
+            status = struct.pack("<IIIHHHHBBBBBBBBb3x", start,
+                                 start + step * steps, self.listen_at, step,
+                                 steps, self.trigger,
+                                 self.sweeps() & 0xFFFF, index, count, bw,
+                                 modulation, 2 if self.listen_at else 0,
+                                 True, self.armed, bool(self.listen_at), -4)
+        return struct.pack("<HH", reply, len(status)) + status
+
+    def sweeps(self):
+        _, _, steps = self.spectrum_range()
+        return int((time.monotonic() - self.spectrum_since) /
+                   (SWEEP_STEP * steps))
+
+    def spectrum_peaks(self, count, rssi_min):
+        found = []
+        if self.spectrum:
+            start, step, steps = self.spectrum_range()
+            for f, rssi in CARRIERS:
+                i = (f - start + step // 2) // step
+                rssi += random.randint(-4, 4)
+                if 0 <= i < min(steps, 128) and rssi >= rssi_min:
+                    found.append((start + i * step, rssi, i))
+        found.sort(key=lambda peak: -peak[1])
+        data = b"".join(struct.pack("<IHH", *peak)
+                        for peak in found[:min(count, SPECTRUM_PEAKS_MAX)])
+        sweeps = self.sweeps() if self.spectrum else 0
+        return struct.pack("<HHHBx", 0x054E, 4 + len(data), sweeps & 0xFFFF,
+                           len(data) // 8) + data
+
+    def scan_hits(self):
+        """log the made up scan hits up to now"""
+        now = time.monotonic()
+        while self.hit_next <= now:
+            channel = random.randrange(len(CARRIERS))
+            f, rssi = CARRIERS[channel]
+            code_type, code = random.choice(((0, 0), (1, 12), (2, 23)))
+            self.hits.append(struct.pack(
+                "<IIHHBBBB", int((self.hit_next - self.boot) * 100), f,
+                rssi + random.randint(0, 20), random.randint(5, 300),
+                len(self.hits) & 0xFF, channel, code_type << 4, code))
+            self.hit_next += SCAN_HIT_EVERY
+
+    def scan_log_reply(self, first, count):
+        self.scan_hits()
+        following = len(self.hits)
+        oldest = max(0, following - SCANLOG_KEPT)
+        if (following - first) & 0xFFFF > following - oldest:
+            first = oldest
+        entries = self.hits[first:first + min(count, SCANLOG_BATCH)]
+        data = struct.pack("<IHHHBx",
+                           int((time.monotonic() - self.boot) * 100), first,
+                           following, 0, len(entries)) + b"".join(entries)
+        return struct.pack("<HH", 0x0552, len(data)) + data
+
+    def hears(self, host_baud):
+        if self.deaf_above and self.baud > self.deaf_above:
+            return False
+        return host_baud == self.baud
+
+    def receive(self, data):
+        self.rx += data
+        replies = []
+        while True:
+            body = self.next_command()
+            if body is None:
+                return replies
+            reply = self.command(body)
+            if reply is not None:
+                replies.append(reply)
+
+    def next_command(self):
+        """body of the next complete and intact frame received"""
+        while True:
+            start = self.rx.find(b"\xab\xcd")
+            if start < 0:
+                self.rx = self.rx[-1:]
+                return None
+            self.rx = self.rx[start:]
+            if len(self.rx) < 4:
+                return None
+            size = struct.unpack("<H", self.rx[2:4])[0]
+            if size < 4 or size + 8 > self.ring - 1:
+                self.rx = self.rx[2:]
+                continue
+            if len(self.rx) < size + 8:
+                return None
+            packet, self.rx = self.rx[:size + 8], self.rx[size + 8:]
+            if packet[-2:] != b"\xdc\xba":
+                continue
+            body = xor(packet[4:size + 6])
+            if crc16(body[:size]) != struct.unpack("<H", body[size:])[0]:
+                self.log("bad crc")
+                continue
+            return body[:size]
+
+    def frame(self, reply):
+        footer = bytes([OBFUSCATION[len(reply) % 16] ^ 0xFF,
+                        OBFUSCATION[(len(reply) + 1) % 16] ^ 0xFF])
+        return (b"\xab\xcd" + struct.pack("<H", len(reply)) + xor(reply) +
+                footer + b"\xdc\xba")
+
+    def command(self, body):
+        cmd = struct.unpack("<H", body[:2])[0]
+        self.log("command %04x", cmd)
+        self.confirm_by = None
+        self.idle_by = time.monotonic() + SESSION_IDLE
+
+        if cmd == 0x0514:
+            self.timestamp = body[4:8]
+            self.telemetry = 0
+            version = b"fake radio".ljust(16, b"\0")
+            data = version + bytes([0, 0, CAPS_MAGIC, self.caps]) + \
+                bytes(16)
+            return struct.pack("<HH", 0x0515, len(data)) + data
+
+        if cmd == 0x05DD:
+            self.log("reset")
+            self.set_baud(BAUD_DEFAULT)
+            return None
+
+        if cmd == 0x051B:
+            offset, size = struct.unpack("<HB", body[4:7])
+            if body[8:12] != self.timestamp:
+                return None
+            data = struct.pack("<HBB", offset, size, 0) + \
+                bytes(self.eeprom[offset:offset + size])
+            return struct.pack("<HH", 0x051C, size + 4) + data
+
+        if cmd == 0x051D:
+            offset, size = struct.unpack("<HB", body[4:7])
+            if body[8:12] != self.timestamp:
+                return None
+            self.write(offset, body[12:12 + size // 8 * 8])
+            return struct.pack("<HHH", 0x051E, 2, offset)
+
+        if cmd == 0x0535 and self.caps & CAP_BULK:
+            offset, size = struct.unpack("<HH", body[4:8])
+            if body[8:12] != self.timestamp:
+                return None
+            size = max(0, min(size, BULK_READ_MAX, len(self.eeprom) - offset))
+            return struct.pack("<HHHH", 0x0536, size + 4, offset, size) + \
+                bytes(self.eeprom[offset:offset + size])
+
+        if cmd == 0x0537 and self.caps & CAP_BULK:
+            offset, size = struct.unpack("<HH", body[4:8])
+            if body[12:16] != self.timestamp:
+                return None
+            size = min(size, self.bulk_write_max, len(body) - 16) // 8 * 8
+            self.write(offset, body[16:16 + size])
+            return struct.pack("<HHHH", 0x0538, 4, offset, size)
+
+        if cmd == 0x0539 and self.caps & CAP_BLOCK_CRC:
+            offset, count = struct.unpack("<HH", body[4:8])
+            if body[8:12] != self.timestamp:
+                return None
+            count = min(count, CRC_BLOCKS_MAX)
+            if offset % CRC_BLOCK_SIZE or offset >= len(self.eeprom):
+                count = 0
+            count = min(count, (len(self.eeprom) - offset) // CRC_BLOCK_SIZE)
+            crcs = [crc16(self.eeprom[a:a + CRC_BLOCK_SIZE]) for a in
+                    range(offset, offset + count * CRC_BLOCK_SIZE,
+                          CRC_BLOCK_SIZE)]
+            return struct.pack("<HHHH", 0x053A, 4 + count * 2, offset,
+                               count) + struct.pack("<%iH" % count, *crcs)
+
+        if cmd == 0x053B and self.caps & CAP_BAUD_RATE:
+            baud = struct.unpack("<I", body[4:8])[0]
+            if body[8:12] != self.timestamp:
+                return None
+            accepted = baud in BAUD_RATES
+            reply = struct.pack("<HHIB3x", 0x053C, 8,
+                                baud if accepted else self.baud, accepted)
+            # the reply leaves at the old rate, then the radio switches
+            return reply, (baud if accepted and baud != self.baud else None)
+
+        if cmd == 0x053D and self.caps & CAP_FLOW:
+            if body[4:8] != self.timestamp:
+                return None
+            # replies go out as each command is parsed, so the ring is
+            # never seen holding anything but the command itself
+            return struct.pack("<HHHHHH", 0x053E, 8, self.ring,
+                               self.ring - 1, self.ring - 9,
+                               self.bulk_write_max)
+
+        if cmd == 0x053F and self.caps & CAP_TELEMETRY:
+            period = struct.unpack("<H", body[4:6])[0]
+            if body[8:12] != self.timestamp:
+                return None
+            if period:
+                period = max(period, TELEMETRY_PERIOD_MIN)
+            if period != self.telemetry:
+                self.telemetry_next = time.monotonic() + period / 100
+            self.telemetry = period
+            self.telemetry_until = time.monotonic() + TELEMETRY_LEASE
+            return struct.pack("<HHH2x", 0x0540, 4, period)
+
+        if cmd == 0x0543 and self.caps & CAP_REMOTE:
+            full = body[4]
+            if body[8:12] != self.timestamp:
+                return None
+            pages, code = 0, b""
+            crcs = []
+            for page in range(SCREEN_PAGES):
+                data = bytes(self.screen[page * SCREEN_WIDTH:
+                                         (page + 1) * SCREEN_WIDTH])
+                crcs.append(crc16(data))
+                if full or not self.screen_crcs or \
+                        crcs[page] != self.screen_crcs[page]:
+                    self.screen_pending |= 1 << page
+            self.screen_crcs = crcs
+            for page in range(SCREEN_PAGES):
+                if not self.screen_pending & (1 << page):
+                    continue
+                coded = rle_encode(bytes(self.screen[page * SCREEN_WIDTH:
+                                                     (page + 1) * SCREEN_WIDTH]))
+                if len(code) + len(coded) <= SCREEN_DATA_MAX:
+                    pages |= 1 << page
+                    code += coded
+            self.screen_pending &= ~pages
+            return struct.pack("<HHBB2x", 0x0544, 4 + len(code), pages,
+                               self.screen_pending) + code
+
+        if cmd == 0x0545 and self.caps & CAP_REMOTE:
+            key, hold = struct.unpack("<BxH", body[4:8])
+            if body[8:12] != self.timestamp:
+                return None
+            now = time.monotonic()
+            accepted = (key < KEY_INVALID and key != KEY_PTT and
+                        now >= self.key_busy_until)
+            if accepted:
+                self.log("key %i for %i ms", key, max(hold, 5) * 10)
+                self.key_busy_until = now + max(hold, 5) / 100 + KEY_RELEASE
+                page = 1 + key % (SCREEN_PAGES - 1)
+                for column in range(key * 6, key * 6 + 5):
+                    self.screen[page * SCREEN_WIDTH + column] ^= 0xFF
+            return struct.pack("<HHBB2x", 0x0546, 4, key, accepted)
+
+        if cmd in (0x0549, 0x054B, 0x054D, 0x054F) and \
+                self.caps & CAP_SPECTRUM:
+            if body[-4:] != self.timestamp:
+                return None
+            if cmd == 0x0549:
+                setup = struct.unpack("<IBBBBB3x", body[4:16])
+                if setup[1] == 1:
+                    self.log("spectrum around %.5f MHz", setup[0] / 1e5)
+                    self.spectrum = (setup[0],) + setup[2:]
+                    self.spectrum_since = time.monotonic()
+                    self.listen_at = 0
+                elif setup[1] == 2:
+                    self.spectrum = None
+            elif cmd == 0x054B:
+                level, self.armed = struct.unpack("<H?x", body[4:8])
+                self.trigger = level or self.trigger
+            elif cmd == 0x054D:
+                return self.spectrum_peaks(*struct.unpack("<BxH", body[4:8]))
+            elif self.spectrum:
+                self.listen_at = struct.unpack("<I", body[4:8])[0]
+            return self.spectrum_status(cmd + 1)
+
+        # not in the caps byte, a radio without the log just ignores it
+        if cmd == 0x0551 and self.scan_log:
+            if body[-4:] != self.timestamp:
+                return None
+            return self.scan_log_reply(*struct.unpack("<HB", body[4:7]))
+
+        self.log("ignored command %04x", cmd)
+        return None
+
+    def write(self, offset, data):
+        self.eeprom[offset:offset + len(data)] = data
+
+
+class Pace:
+    """the radio at its own speed, see --realtime"""
+
+    def __init__(self, radio, master):
+        self.radio = radio
+        self.master = master
+        self.inbound = []       # (arrival time, bytes)
+        self.outbound = []      # (departure time, frame, rate to switch to)
+        self.rx_idle = 0.0      # the wire into the radio is free from then
+        self.tx_idle = 0.0      # and the one out of it
+        self.next_slice = 0.0
+
+    def wire_time(self, size):
+        return size * CHAR_BITS / self.radio.baud
+
+    def receive(self, data):
+        now = time.monotonic()
+        self.rx_idle = max(now, self.rx_idle) + self.wire_time(len(data))
+        self.inbound.append((self.rx_idle, data))
+
+    def send(self, reply):
+        switch = None
+        if isinstance(reply, tuple):
+            reply, switch = reply
+        frame = self.radio.frame(reply)
+        now = time.monotonic()
+        self.tx_idle = max(now, self.tx_idle) + self.wire_time(len(frame))
+        self.outbound.append((self.tx_idle, frame, switch))
+
+    def run(self):
+        radio = self.radio
+        now = time.monotonic()
+
+        while self.inbound and self.inbound[0][0] <= now:
+            radio.rx += self.inbound.pop(0)[1]
+            # the DMA goes round and writes over what was not handled yet
+            if len(radio.rx) > radio.ring - 1:
+                radio.log("receive ring overrun, %i bytes lost",
+                          len(radio.rx) - (radio.ring - 1))
+                radio.rx = radio.rx[len(radio.rx) - (radio.ring - 1):]
+
+        if now >= self.next_slice:
+            self.next_slice = now + SLICE
+            body = radio.next_command()
+            if body is not None:
+                reply = radio.command(body)
+                if reply is not None:
+                    self.send(reply)
+
+        while self.outbound and self.outbound[0][0] <= now:
+            _, frame, switch = self.outbound.pop(0)
+            os.write(self.master, frame)
+            if switch:
+                radio.set_baud(switch)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--image", help="EEPROM image, written back on exit")
+    parser.add_argument("--size", type=lambda x: int(x, 0), default=0x2000,
+                        help="EEPROM size without an image")
+    parser.add_argument("--caps", type=lambda x: int(x, 0),
+                        default=CAP_BULK | CAP_BLOCK_CRC | CAP_BAUD_RATE |
+                        CAP_FLOW | CAP_TELEMETRY | CAP_REMOTE,
+                        help="capabilities to advertise, 0 for stock")
+    parser.add_argument("--ring", type=int, default=256,
+                        help="receive ring size the radio was built with")
+    parser.add_argument("--deaf-above", type=int, default=0,
+                        help="lose everything above this baud rate, as "
+                        "with a cable that cannot keep up")
+    parser.add_argument("--scan-log", action="store_true",
+                        help="answer for a scan log with made up hits")
+    parser.add_argument("--realtime", action="store_true",
+                        help="keep the pace of a real radio")
+    parser.add_argument("--link", help="symlink to create for the pty")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    if args.image and os.path.exists(args.image):
+        with open(args.image, "rb") as f:
+            eeprom = bytearray(f.read())
+    else:
+        eeprom = bytearray(b"\xff" * args.size)
+
+    radio = Radio(eeprom, args.caps, args.ring, args.deaf_above,
+                  args.scan_log, args.verbose)
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+
+    master, slave = pty.openpty()
+    tty.setraw(slave)
+    name = os.ttyname(slave)
+    if args.link:
+        if os.path.lexists(args.link):
+            os.unlink(args.link)
+        os.symlink(name, args.link)
+    print(name, flush=True)
+
+    pace = Pace(radio, master) if args.realtime else None
+
+    try:
+        while True:
+            ready, _, _ = select.select([master], [], [],
+                                        0.001 if pace or radio.telemetry
+                                        or radio.caps & CAP_TRACE
+                                        else 0.05)
+            radio.tick()
+            for record in (radio.telemetry_due(), radio.trace_due()):
+                if record and pace:
+                    pace.send(record)
+                elif record:
+                    os.write(master, radio.frame(record))
+            if pace:
+                pace.run()
+            if not ready:
+                continue
+            try:
+                data = os.read(master, 4096)
+            except OSError:
+                continue
+            host_baud = SPEEDS.get(termios.tcgetattr(slave)[5])
+            if not radio.hears(host_baud):
+                radio.log("lost %i bytes at %s baud", len(data), host_baud)
+                continue
+            if pace:
+                pace.receive(data)
+                continue
+            for reply in radio.receive(data):
+                switch = None
+                if isinstance(reply, tuple):
+                    reply, switch = reply
+                os.write(master, radio.frame(reply))
+                if switch:
+                    radio.set_baud(switch)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if args.link and os.path.lexists(args.link):
+            os.unlink(args.link)
+        if args.image:
+            with open(args.image, "wb") as f:
+                f.write(radio.eeprom)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,200 @@
+"""Programming cable link to a radio running this firmware, shared by the
+host tools in utils/.
+
+Frames are 0xAB 0xCD, a 16 bit length, the obfuscated body and its
+CRC16, and 0xDC 0xBA. The radio obfuscates its replies unless the session
+was opened with a plain hello; these tools always obfuscate.
+"""
+
+import os
+import select
+import struct
+import termios
+import time
+import tty
+
+OBFUSCATION = [0x16, 0x6C, 0x14, 0xE6, 0x2E, 0x91, 0x0D, 0x40,
+               0x21, 0x35, 0xD5, 0x40, 0x13, 0x03, 0xE9, 0x80]
+
+# session id sent with every command
+TIMESTAMP = b"\x6a\x39\x57\x64"
+
+BAUD_DEFAULT = 38400
+
+# capabilities advertised in the hello reply
+CAPS_MAGIC = 0xC5
+CAP_BULK = 0x01
+CAP_BLOCK_CRC = 0x02
+CAP_BAUD_RATE = 0x04
+CAP_FLOW = 0x08
+CAP_TELEMETRY = 0x10
+CAP_REMOTE = 0x20
+CAP_TRACE = 0x40
+CAP_SPECTRUM = 0x80
+
+# spectrum scan steps by index, 10 Hz
+SPECTRUM_STEPS = (1, 10, 50, 100, 250, 500, 625, 833, 1000, 1250, 1500,
+                  2000, 2500, 5000, 10000)
+
+SPEEDS = {b: getattr(termios, "B%i" % b) for b in
+          (9600, 19200, 38400, 57600, 115200, 230400)}
+
+
+def xor(data):
+    return bytes(b ^ OBFUSCATION[i % 16] for i, b in enumerate(data))
+
+
+def crc16(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc <<= 1
+            if crc & 0x10000:
+                crc = (crc ^ 0x1021) & 0xFFFF
+    return crc
+
+
+def rle_encode(data):
+    """run length code as the firmware does for screen pages: a control
+    byte below 0x80 is followed by that many plus one bytes as they are,
+    one from 0x80 up by a byte repeating (control - 0x80 + 3) times"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and run < 130 and data[i + run] == data[i]:
+            run += 1
+        if run >= 3:
+            out += bytes([0x80 + run - 3, data[i]])
+            i += run
+            continue
+        run = 1
+        while i + run < len(data) and run < 128:
+            j = i + run
+            if j + 2 < len(data) and data[j] == data[j + 1] == data[j + 2]:
+                break
+            run += 1
+        out += bytes([run - 1]) + data[i:i + run]
+        i += run
+    return bytes(out)
+
+
+def rle_decode(code, size):
+    """size bytes decoded from the start of code, and the rest of code"""
+    out = bytearray()
+    i = 0
+    while len(out) < size:
+        if i >= len(code):
+            raise LinkError("run length code cut short")
+        control = code[i]
+        if control < 0x80:
+            out += code[i + 1:i + 2 + control]
+            i += 2 + control
+        else:
+            out += code[i + 1:i + 2] * (control - 0x80 + 3)
+            i += 2
+    if len(out) != size:
+        raise LinkError("run length code overruns its page")
+    return bytes(out), code[i:]
+
+
+class LinkError(Exception):
+    pass
+
+
+class Port:
+    """the bits of a pyserial port the tools and the chirp driver use, on
+    a serial device or a pty"""
+
+    def __init__(self, path, baudrate=BAUD_DEFAULT):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        self.timeout = 0.5
+        self._baudrate = None
+        self.baudrate = baudrate
+
+    @property
+    def baudrate(self):
+        return self._baudrate
+
+    @baudrate.setter
+    def baudrate(self, baudrate):
+        attr = termios.tcgetattr(self.fd)
+        attr[4] = attr[5] = SPEEDS[baudrate]
+        termios.tcsetattr(self.fd, termios.TCSANOW, attr)
+        self._baudrate = baudrate
+
+    def write(self, data):
+        return os.write(self.fd, data)
+
+    def read(self, size):
+        data = b""
+        end = time.monotonic() + self.timeout
+        while len(data) < size:
+            ready, _, _ = select.select([self.fd], [], [],
+                                        max(0, end - time.monotonic()))
+            if not ready:
+                break
+            data += os.read(self.fd, size - len(data))
+        return data
+
+    def flush(self):
+        termios.tcdrain(self.fd)
+
+    def reset_input_buffer(self):
+        termios.tcflush(self.fd, termios.TCIFLUSH)
+
+    def close(self):
+        os.close(self.fd)
+
+
+class Link:
+    def __init__(self, port):
+        self.port = port
+
+    def send(self, cmd, payload=b"", timestamp=True):
+        """send command cmd, payload is what follows its header"""
+        if timestamp:
+            payload += TIMESTAMP
+        body = struct.pack("<HH", cmd, len(payload)) + payload
+        self.port.write(b"\xab\xcd" + struct.pack("<H", len(body)) +
+                        xor(body + struct.pack("<H", crc16(body))) +
+                        b"\xdc\xba")
+
+    def receive(self):
+        """(id, payload) of the next reply, None when none came in time"""
+        while True:
+            byte = self.port.read(1)
+            if not byte:
+                return None
+            if byte != b"\xab" or self.port.read(1) != b"\xcd":
+                continue
+            size = self.port.read(2)
+            if len(size) != 2:
+                return None
+            size = struct.unpack("<H", size)[0]
+            rest = self.port.read(size + 4)
+            if len(rest) != size + 4 or rest[-2:] != b"\xdc\xba":
+                raise LinkError("short or broken reply")
+            body = xor(rest[:size])
+            if len(body) < 4:
+                raise LinkError("reply without a header")
+            return struct.unpack("<H", body[:2])[0], body[4:]
+
+    def expect(self, cmd):
+        """payload of the reply cmd, skipping anything else on the way"""
+        end = time.monotonic() + 2 * self.port.timeout
+        while time.monotonic() < end:
+            reply = self.receive()
+            if reply and reply[0] == cmd:
+                return reply[1]
+        raise LinkError("no reply %04x" % cmd)
+
+    def hello(self):
+        """open a session, (firmware version, capabilities)"""
+        self.send(0x0514)
+        data = self.expect(0x0515)
+        version = data[:16].split(b"\0")[0].decode("ascii", "replace")
+        caps = data[19] if len(data) > 19 and data[18] == CAPS_MAGIC else 0
+        return version, caps
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Show the radio's screen live and press its keys over the cable.
+
+The firmware sends only the screen pages that changed since the last
+dump, run length coded and as many as fit its transmit ring per reply, which keeps up a few frames a second at 38400
+baud. Keys go in as if pressed on the keypad (PTT excepted).
+
+Live, in a terminal:
+
+    utils/remote_screen.py /dev/ttyUSB0
+
+0-9 * # and m (MENU), e or Esc (EXIT), the arrow keys, [ and ] (side
+keys), capitals hold the key; r redraws everything, q quits.
+
+Scripted, e.g. for UI regression tests:
+
+    utils/remote_screen.py /dev/ttyUSB0 --keys "MENU DOWN:600 wait:300
+        check:menu.pbm EXIT"
+
+A script is keys by name (0-9 MENU UP DOWN EXIT STAR F SIDE1 SIDE2),
+optionally with :ms to hold them, wait:ms, shot:FILE.pbm to save the
+screen and check:FILE.pbm to compare it with a saved one; a mismatch
+saves FILE.actual.pbm and fails. --script takes the same from a file,
+where # starts a comment.
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+from radio_link import CAP_REMOTE, Link, LinkError, Port, rle_decode
+
+PAGES = 8
+WIDTH = 128
+HEIGHT = PAGES * 8
+
+KEYS = {"0": 0, "1": 1, "2": 2, "3": 3, "4": 4, "5": 5, "6": 6, "7": 7,
+        "8": 8, "9": 9, "MENU": 10, "UP": 11, "DOWN": 12, "EXIT": 13,
+        "STAR": 14, "F": 15, "SIDE2": 17, "SIDE1": 18}
+
+# terminal keys in live mode
+TERMINAL_KEYS = {"m": "MENU", "e": "EXIT", "\x1b": "EXIT", "*": "STAR",
+                 "#": "F", "[": "SIDE1", "]": "SIDE2",
+                 "\x1b[A": "UP", "\x1b[B": "DOWN"}
+
+PRESS = 100         # ms a key is held down
+LONG_PRESS = 1000   # and held
+FULL_EVERY = 10.0   # seconds between full dumps, against missed changes
+
+
+class Screen:
+    def __init__(self, link):
+        self.link = link
+        self.pages = [bytes(WIDTH)] * PAGES
+
+    def update(self, full=False):
+        """fetch the pages that changed, True when any did"""
+        changed = 0
+        while True:
+            self.link.send(0x0543, struct.pack("<B3x", bool(full)))
+            data = self.link.expect(0x0544)
+            pages, pending = data[0], data[1]
+            code = data[4:]
+            for page in range(PAGES):
+                if pages & (1 << page):
+                    self.pages[page], code = rle_decode(code, WIDTH)
+            changed |= pages
+            # a reply holds what fits the radio's transmit ring
+            if not pending:
+                return changed != 0
+            full = False
+
+    def pixel(self, x, y):
+        return (self.pages[y // 8][x] >> (y % 8)) & 1
+
+    def pbm(self):
+        rows = []
+        for y in range(HEIGHT):
+            row = 0
+            for x in range(WIDTH):
+                row = (row << 1) | self.pixel(x, y)
+            rows.append(row.to_bytes(WIDTH // 8, "big"))
+        return b"P4\n%i %i\n" % (WIDTH, HEIGHT) + b"".join(rows)
+
+    def text(self):
+        """the screen in half block characters, two pixel rows a line"""
+        chars = " ▀▄█"
+        lines = []
+        for y in range(0, HEIGHT, 2):
+            lines.append("".join(chars[self.pixel(x, y) |
+                                       self.pixel(x, y + 1) << 1]
+                                 for x in range(WIDTH)))
+        return "\n".join(lines)
+
+
+def press(link, name, hold_ms=PRESS):
+    """press a key and wait until the radio has let go of it"""
+    key = KEYS[name]
+    hold = max(1, hold_ms // 10)
+    end = time.monotonic() + 2
+    while True:
+        link.send(0x0545, struct.pack("<BxH", key, hold))
+        if link.expect(0x0546)[1]:
+            break
+        if time.monotonic() > end:
+            raise LinkError("radio did not take key %s" % name)
+        time.sleep(0.02)
+    time.sleep(hold / 100 + 0.06)
+
+
+def run_script(link, screen, tokens):
+    for token in tokens:
+        what, _, arg = token.partition(":")
+        if what == "wait":
+            time.sleep(int(arg) / 1000)
+        elif what in ("shot", "check"):
+            screen.update(full=True)
+            if what == "shot":
+                with open(arg, "wb") as f:
+                    f.write(screen.pbm())
+                continue
+            with open(arg, "rb") as f:
+                if f.read() == screen.pbm():
+                    print("%s: same" % arg, file=sys.stderr)
+                    continue
+            actual = os.path.splitext(arg)[0] + ".actual.pbm"
+            with open(actual, "wb") as f:
+                f.write(screen.pbm())
+            print("%s: differs, see %s" % (arg, actual), file=sys.stderr)
+            return False
+        elif what.upper() in KEYS:
+            press(link, what.upper(), int(arg) if arg else PRESS)
+        else:
+            raise SystemExit("unknown script step %s" % token)
+    return True
+
+
+def live(link, screen):
+    fd = sys.stdin.fileno()
+    saved = termios.tcgetattr(fd)
+    tty.setcbreak(fd)
+    sys.stdout.write("\x1b[2J\x1b[?25l")
+    full_at = 0
+    try:
+        while True:
+            now = time.monotonic()
+            changed = screen.update(full=now >= full_at)
+            if now >= full_at:
+                full_at = now + FULL_EVERY
+            if changed:
+                sys.stdout.write("\x1b[H" + screen.text() + "\n")
+                sys.stdout.flush()
+
+            if not select.select([fd], [], [], 0.1)[0]:
+                continue
+            typed = os.read(fd, 8).decode("ascii", "ignore")
+            if typed == "q":
+                break
+            if typed == "r":
+                full_at = 0
+                continue
+            name = (TERMINAL_KEYS.get(typed) or
+                    TERMINAL_KEYS.get(typed.lower()) or typed.upper())
+            if name in KEYS:
+                press(link, name, LONG_PRESS if typed.isupper() else PRESS)
+    finally:
+        sys.stdout.write("\x1b[?25h")
+        termios.tcsetattr(fd, termios.TCSADRAIN, saved)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", help="serial port of the programming cable")
+    parser.add_argument("--keys", help="script to run, see above")
+    parser.add_argument("--script", help="file with a script to run")
+    parser.add_argument("--live", action="store_true",
+                        help="show the screen after the script")
+    args = parser.parse_args()
+
+    link = Link(Port(args.port))
+    firmware, caps = link.hello()
+    if not caps & CAP_REMOTE:
+        sys.exit("%s has no remote screen" % (firmware or "the radio"))
+
+    screen = Screen(link)
+    tokens = []
+    if args.script:
+        with open(args.script) as f:
+            for line in f:
+                tokens += line.split("#")[0].split()
+    if args.keys:
+        tokens += args.keys.split()
+
+    if tokens and not run_script(link, screen, tokens):
+        sys.exit(1)
+    if not tokens or args.live:
+        live(link, screen)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Fetch the radio's log of scan hits.
+
+A firmware built with ENABLE_SCAN_LOG=1 logs each signal the scanner or
+the spectrum trigger stopped on: when, the frequency and channel, the
+peak RSSI, the CTCSS/DCS code it matched and how long it stayed there.
+This prints the log, and with --follow keeps printing new hits as they
+come, to sit next to an unattended scan. Tone and code values come from
+src/dcs.c.
+
+    utils/scan_log.py /dev/ttyUSB0
+    utils/scan_log.py /dev/ttyUSB0 --follow --csv hits.csv
+
+Hits of this boot are put on the wall clock. Hits kept in EEPROM from an
+earlier boot (ENABLE_SCAN_LOG_EEPROM=1) only have their time since that
+boot, printed as +seconds.
+"""
+
+import argparse
+import csv
+import os
+import re
+import struct
+import sys
+import time
+
+from radio_link import Link, LinkError, Port
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TABLES = os.path.join(HERE, "..", "src", "dcs.c")
+
+HEADER = struct.Struct("<IHHHBx")
+ENTRY = struct.Struct("<IIHHBBBB")
+BATCH = 8                   # most entries in a reply
+TICK = 0.010                # gGlobalSysTickCounter period
+
+SOURCES = ("scan", "spectrum")
+CODE_TONE = 1
+CODE_DIGITAL = 2
+CODE_REVERSE_DIGITAL = 3
+
+
+def read_table(text, name):
+    m = re.search(r"%s\[\d*\]\s*=\s*\{(.*?)\}" % name, text, re.S)
+    if not m:
+        raise SystemExit("no %s in %s" % (name, TABLES))
+    return [int(v, 0) for v in m.group(1).replace(",", " ").split()]
+
+
+def read_tables(path):
+    """(CTCSS tenths of Hz, DCS codes) by index"""
+    with open(path) as f:
+        text = f.read()
+    return read_table(text, "CTCSS_Options"), read_table(text, "DCS_Options")
+
+
+def describe_code(tables, code_type, code):
+    ctcss, dcs = tables
+    if code_type == CODE_TONE and code < len(ctcss):
+        return "%.1f Hz" % (ctcss[code] / 10)
+    if code_type in (CODE_DIGITAL, CODE_REVERSE_DIGITAL) and code < len(dcs):
+        return "D%03o%s" % (dcs[code],
+                            "N" if code_type == CODE_DIGITAL else "I")
+    return ""
+
+
+class Hit:
+    def __init__(self, number, data):
+        (self.tick, self.frequency, self.rssi, self.dwell, _,
+         self.channel, source, self.code) = ENTRY.unpack(data)
+        self.number = number
+        self.source = source & 0x0F
+        self.code_type = source >> 4
+
+    def dbm(self):
+        return self.rssi / 2 - 160
+
+
+def fetch(link, first):
+    """(radio tick now, first boot hit, next hit, [hits]) from first on"""
+    link.send(0x0551, struct.pack("<HBx", first & 0xFFFF, BATCH))
+    data = link.expect(0x0552)
+    tick, start, following, boot_first, count = HEADER.unpack_from(data)
+    hits = [Hit((start + i) & 0xFFFF,
+                data[HEADER.size + i * ENTRY.size:
+                     HEADER.size + (i + 1) * ENTRY.size])
+            for i in range(count)]
+    return tick, boot_first, following, hits
+
+
+def fetch_all(link, first):
+    """like fetch, but every hit from first on"""
+    hits = []
+    while True:
+        tick, boot_first, following, batch = fetch(link, first)
+        hits += batch
+        if not batch:
+            return tick, boot_first, following, hits
+        first = batch[-1].number + 1
+        if first & 0xFFFF == following:
+            return tick, boot_first, following, hits
+
+
+def this_boot(hit, boot_first, following):
+    # numbers wrap, what matters is how far back from the next one
+    return (following - hit.number) & 0xFFFF <= \
+        (following - boot_first) & 0xFFFF
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", help="serial port of the programming cable")
+    parser.add_argument("--follow", action="store_true",
+                        help="keep printing new hits")
+    parser.add_argument("--interval", type=float, default=2.0,
+                        help="seconds between looks with --follow")
+    parser.add_argument("--new", action="store_true",
+                        help="only hits from now on")
+    parser.add_argument("--csv", help="also append the hits to this file")
+    parser.add_argument("--tables", default=TABLES,
+                        help="dcs.c the firmware was built with")
+    args = parser.parse_args()
+
+    tables = read_tables(args.tables)
+    link = Link(Port(args.port))
+    firmware, _ = link.hello()
+    # the caps byte has no room left to advertise the log, so just ask
+    try:
+        _, _, first, _ = fetch(link, 0)
+    except LinkError:
+        sys.exit("%s has no scan log" % (firmware or "the radio"))
+    if not args.new:
+        first = 0
+
+    out = None
+    if args.csv:
+        new_file = not os.path.exists(args.csv)
+        f = open(args.csv, "a", newline="")
+        out = csv.writer(f)
+        if new_file:
+            out.writerow(("number", "time", "source", "channel", "mhz",
+                          "dbm", "code", "dwell_s"))
+
+    try:
+        while True:
+            try:
+                tick, boot_first, following, hits = fetch_all(link, first)
+            except LinkError as e:
+                print("no log: %s" % e, file=sys.stderr)
+                hits = []
+            now = time.time()
+            for hit in hits:
+                if this_boot(hit, boot_first, following):
+                    when = time.strftime(
+                        "%Y-%m-%d %H:%M:%S",
+                        time.localtime(now - (tick - hit.tick) * TICK))
+                else:
+                    when = "+%.1f" % (hit.tick * TICK)
+                channel = "" if hit.channel == 0xFF else hit.channel + 1
+                source = (SOURCES[hit.source] if hit.source < len(SOURCES)
+                          else hit.source)
+                code = describe_code(tables, hit.code_type, hit.code)
+                print("%5i %-19s %-8s %3s %10.5f MHz %6.1f dBm %-10s %6.1f s"
+                      % (hit.number, when, source, channel,
+                         hit.frequency / 1e5, hit.dbm(), code or "-",
+                         hit.dwell / 10), flush=True)
+                if out:
+                    out.writerow((hit.number, when, source, channel,
+                                  "%.5f" % (hit.frequency / 1e5),
+                                  "%.1f" % hit.dbm(), code,
+                                  "%.1f" % (hit.dwell / 10)))
+                    f.flush()
+                first = hit.number + 1
+            if not args.follow:
+                break
+            time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if out:
+            f.close()
+
+
+if __name__ == "__main__":
+    main()
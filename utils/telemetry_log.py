@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Log the radio's telemetry stream to CSV.
+
+Subscribes to the records the firmware pushes at a fixed rate (RSSI,
+noise, glitch, AM fix gain index, receive gain, battery voltage and what
+the radio is doing) and writes one line per record, for characterising
+sites and antennas over time. The subscription is renewed as it goes;
+lost records show up as gaps in the sequence column and are counted at
+the end.
+
+    utils/telemetry_log.py /dev/ttyUSB0 --period 100 -o site.csv
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import time
+
+from radio_link import CAP_TELEMETRY, Link, LinkError, Port
+
+RENEW = 10.0    # seconds between renewals, the radio gives up after 30
+
+FUNCTIONS = ("foreground", "transmit", "monitor", "incoming", "receive",
+             "power_save", "band_scope")
+
+COLUMNS = ("host_time", "radio_time", "sequence", "rssi_dbm", "rssi_raw",
+           "noise", "glitch", "am_fix_index", "rx_gain_db", "battery_v",
+           "function")
+
+
+def subscribe(link, period):
+    link.send(0x053F, struct.pack("<H2x", period))
+    return struct.unpack("<H", link.expect(0x0540)[:2])[0]
+
+
+def decode(payload):
+    (tick, sequence, rssi, noise, glitch, am_fix, gain, voltage,
+     function) = struct.unpack("<IHHBBBbHBx", payload[:16])
+    return {
+        "radio_time": "%.2f" % (tick / 100),
+        "sequence": sequence,
+        "rssi_dbm": "%.1f" % (rssi / 2 - 160),
+        "rssi_raw": rssi,
+        "noise": noise,
+        "glitch": glitch,
+        "am_fix_index": am_fix,
+        "rx_gain_db": gain,
+        "battery_v": "%.2f" % (voltage / 100),
+        "function": (FUNCTIONS[function] if function < len(FUNCTIONS)
+                     else function),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", help="serial port of the programming cable")
+    parser.add_argument("--period", type=int, default=100,
+                        help="milliseconds between records (min 20)")
+    parser.add_argument("--duration", type=float,
+                        help="seconds to log for, until ^C otherwise")
+    parser.add_argument("-o", "--output", help="CSV file, stdout otherwise")
+    args = parser.parse_args()
+
+    link = Link(Port(args.port))
+    firmware, caps = link.hello()
+    if not caps & CAP_TELEMETRY:
+        sys.exit("%s has no telemetry stream" % (firmware or "the radio"))
+
+    period = subscribe(link, max(1, args.period // 10))
+    print("%s: a record every %i ms" % (firmware, period * 10),
+          file=sys.stderr)
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.DictWriter(out, COLUMNS)
+    writer.writeheader()
+
+    start = time.monotonic()
+    renew = start + RENEW
+    expected = None
+    records = lost = 0
+
+    try:
+        while args.duration is None or \
+                time.monotonic() - start < args.duration:
+            if time.monotonic() >= renew:
+                link.send(0x053F, struct.pack("<H2x", period))
+                renew += RENEW
+            try:
+                reply = link.receive()
+            except LinkError as e:
+                print("skipped a broken frame: %s" % e, file=sys.stderr)
+                continue
+            if reply is None or reply[0] != 0x0542:
+                continue
+
+            row = decode(reply[1])
+            if expected is not None:
+                lost += (row["sequence"] - expected) & 0xFFFF
+            expected = (row["sequence"] + 1) & 0xFFFF
+            records += 1
+
+            row["host_time"] = "%.3f" % time.time()
+            writer.writerow(row)
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        link.send(0x053F, struct.pack("<H2x", 0))
+        if out is not sys.stdout:
+            out.close()
+
+    print("%i records, %i lost" % (records, lost), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Print the radio's binary trace as a timeline.
+
+A firmware built with ENABLE_TRACE=1 queues events from the scan, receive
+and battery paths as an ID and two numbers, and sends them over the
+programming cable whenever it is idle. This only listens, so it can sit
+on the cable while the radio is used. Event names and argument labels
+come from src/helper/trace.h.
+
+    utils/trace_decode.py /dev/ttyUSB0
+    utils/trace_decode.py --file capture.bin --only SCAN_FOUND
+
+Times are since boot, to the 1/6 us the SysTick counts in, with the time
+since the previous event. A capture file is the raw bytes off the cable,
+e.g. from cat /dev/ttyUSB0 > capture.bin with the port set up by stty.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+from radio_link import Link, LinkError, Port, xor
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+HEADER = os.path.join(HERE, "..", "src", "helper", "trace.h")
+
+RECORD = struct.Struct("<IHBxII")
+TICK = 0.010                # gGlobalSysTickCounter period
+CYCLE = 8 / 48e6            # Cycles_8 unit, SysTick at 48 MHz
+
+FUNCTIONS = ("foreground", "transmit", "monitor", "incoming", "receive",
+             "power_save", "band_scope")
+
+# how arguments with these labels read best
+FORMATS = {
+    "function": lambda v: FUNCTIONS[v] if v < len(FUNCTIONS) else str(v),
+    "previous": lambda v: FUNCTIONS[v] if v < len(FUNCTIONS) else str(v),
+    "frequency": lambda v: "%.5f MHz" % (v / 1e5),
+    "voltage": lambda v: "%.2f V" % (v / 100),
+    "percent": lambda v: "%i%%" % v,
+}
+
+
+class CaptureFile:
+    """a capture read as if it came off the port"""
+
+    timeout = 0
+
+    def __init__(self, path):
+        self.f = open(path, "rb")
+
+    def read(self, size):
+        return self.f.read(size)
+
+
+def read_events(path):
+    """{id: (name, [labels])} from the TRACE_Event_t enum"""
+    with open(path) as f:
+        text = f.read()
+    body = re.search(r"typedef enum \{(.*?)\} TRACE_Event_t;", text, re.S)
+    if not body:
+        raise SystemExit("no TRACE_Event_t in %s" % path)
+    events = {}
+    number = 0
+    for line in body.group(1).splitlines():
+        m = re.match(r"\s*TRACE_(\w+)\s*(?:=\s*(\w+))?\s*,\s*(?://(.*))?",
+                     line)
+        if not m:
+            continue
+        if m.group(2):
+            number = int(m.group(2), 0)
+        labels = [label.strip() for label in (m.group(3) or "").split(",")]
+        events[number] = (m.group(1), [label for label in labels if label])
+        number += 1
+    return events
+
+
+def trace_payload(reply):
+    """the payload of a trace frame whether or not the radio obfuscates,
+    None for any other frame"""
+    cmd, payload = reply
+    if cmd == 0x0548:
+        return payload
+    # Link.receive took it off, so putting it back gives the plain frame
+    plain = xor(struct.pack("<HH", cmd, len(payload)) + payload)
+    if struct.unpack("<H", plain[:2])[0] == 0x0548:
+        return plain[4:]
+    return None
+
+
+def records(payload):
+    count = payload[0]
+    for i in range(count):
+        start = 4 + i * RECORD.size
+        if start + RECORD.size > len(payload):
+            raise LinkError("trace frame cut short")
+        yield RECORD.unpack_from(payload, start)
+
+
+def describe(events, event, args):
+    name, labels = events.get(event, ("EVENT_%i" % event, ["a", "b"]))
+    parts = []
+    for label, value in zip(labels, args):
+        fmt = FORMATS.get(label, str)
+        parts.append("%s=%s" % (label, fmt(value)))
+    return name, " ".join(parts)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", nargs="?",
+                        help="serial port of the programming cable")
+    parser.add_argument("--file", help="decode a capture instead")
+    parser.add_argument("--header", default=HEADER,
+                        help="trace.h the firmware was built with")
+    parser.add_argument("--only", action="append", metavar="EVENT",
+                        help="just these events (repeatable)")
+    args = parser.parse_args()
+    if bool(args.port) == bool(args.file):
+        parser.error("give a port or --file")
+
+    events = read_events(args.header)
+    link = Link(CaptureFile(args.file) if args.file else Port(args.port))
+    only = {name.upper() for name in args.only} if args.only else None
+    previous = None
+
+    try:
+        while True:
+            try:
+                reply = link.receive()
+            except LinkError as e:
+                print("skipped a broken frame: %s" % e, file=sys.stderr)
+                continue
+            if reply is None:
+                if args.file:
+                    break
+                continue
+            payload = trace_payload(reply)
+            if payload is None:
+                continue
+
+            for tick, cycles, event, arg0, arg1 in records(payload):
+                when = tick * TICK + cycles * CYCLE
+                delta = when - previous if previous is not None else 0.0
+                previous = when
+                name, text = describe(events, event, (arg0, arg1))
+                if only and name not in only:
+                    continue
+                print("%12.6f %+10.6f  %-16s %s" % (when, delta, name, text),
+                      flush=True)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()